@@ -1,336 +1,503 @@
-/*
- * Copyright (C) 2021 adrian_007, adrian-007 on o2 point pl
- *
- * This program is free software; you can redistribute it and/or modify
- * it under the terms of the GNU General Public License as published by
- * the Free Software Foundation; either version 3 of the License, or
- * (at your option) any later version.
- *
- * This program is distributed in the hope that it will be useful,
- * but WITHOUT ANY WARRANTY; without even the implied warranty of
- * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
- * GNU General Public License for more details.
- *
- * You should have received a copy of the GNU General Public License
- * along with this program; if not, write to the Free Software
- * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
- */
-
-#pragma once
-
-#include <avr/io.h>
-
-#include "Serial.h"
-#include "MCP42100.h"
-#include "Queue.h"
-
-class ADCButtons
-{
-public:
-    enum Button : uint8_t
-    {
-        None, // Special value indicating that no button has been pressed.
-        Select,
-        Next,
-        Up,
-        Prev,
-        Down,
-        Mute,
-        OnOff,
-        VolumeUp,
-        VolumeDown,
-        AnswerCall,
-        HangUpCall,
-        AddressBook
-    };
-
-    static ADCButtons& instance()
-    {
-        static ADCButtons instance;
-        return instance;
-    }
-
-    void init()
-    {
-        MCP42100::init();
-
-        // ADMUX 7:6 = 01 - set voltage reference to AVCC with external capacitor at AREF pin
-        // ADMUX 3:0 = 0111 - select ADC7
-        ADMUX |= (1 << REFS0) | (1 << MUX2) | (1 << MUX1) | (1 << MUX0);
-
-        // 0:2 = 110 - prescaler fcpu/64 = 62,5 kHz
-        ADCSRA |= (1 << ADEN) | (1 << ADSC) | (1 << ADATE) | (1 << ADIE) | (1 << ADPS2) | (1 << ADPS1);
-    }
-
-    void poll()
-    {
-        if (_sampling) {
-            _samplingTime += 10;
-        }
-
-        if (_eventCoolOffDuration < coolOffDuration()) {
-            _eventCoolOffDuration += 10;
-            return;
-        }
-
-        auto* event = _buttonEventQueue.peek();
-        if (!event)
-            return;
-
-        if (event->elapsed >= event->duration) {
-            // Event expired
-            MCP42100::setPOT(POT_TIP_SHUTDOWN | POT_RING_SHUTDOWN, 0);
-            _eventCoolOffDuration = 0;
-            _buttonEventQueue.pop();
-
-            DEBUG_PRINT("Pot shut down");
-        }
-        else {
-            if (event->elapsed == 0) {
-                if (event->pot == POT::Ring) {
-                    DEBUG_PRINT("Setting ring POT to 800 ohms");
-        
-                    MCP42100::setPOT(POT_RING_ADDRESS, resistanceToPotValue(800));
-                }
-        
-                DEBUG_PRINT("Setting tip POT to ", potValueToResistance(event->potValue), " ohms");
-        
-                MCP42100::setPOT(POT_TIP_ADDRESS, event->potValue);
-                event->elapsed = 1;
-            }
-            else {
-                event->elapsed += 10;
-            }
-        }
-    }
-
-    void newSample(uint16_t sample)
-    {
-        auto noButtonPressed { sample >= maxSampleValue() };
-
-        if (noButtonPressed) {
-            if (_sampling) {
-                _sampling = false;
-
-                if (_sampleCount < minSampleCount())
-                    return;
-
-                // Find out which button was pressed.
-
-                for (const auto& buttonInfo : _buttonInfo) {
-                    if (buttonInfo.isInRange(_sampleAvg)) {
-                        auto button { _samplingTime < alternateFunctionSamplingTimeThreshold() ? buttonInfo.button : buttonInfo.alternateButton };
-
-                        DEBUG_PRINT("Sample statistics",
-                            ": min / avg / max: ", _sampleMin, " / ", _sampleAvg, " / ", _sampleMax,
-                            ", sampling time: ", _samplingTime, ", sample count: ", _sampleCount,
-                            ", Button: ", buttonName(button)
-                        );
-
-                        // Find POT definition for given button
-                        for (const auto& buttonPotInfo : _buttonPotInfo) {
-                            if (buttonPotInfo.button == button) {
-                                auto isLongPress { _samplingTime >= alternateFunctionSamplingTimeThreshold() * 2 };
-
-                                uint16_t duration;
-                                if (buttonPotInfo.durationType == POTDurationType::Variable) {
-                                    duration = durationTypeToDuration(isLongPress ? POTDurationType::Long : POTDurationType::Short);
-                                }
-                                else {
-                                    duration = durationTypeToDuration(buttonPotInfo.durationType);
-                                }
-
-                                if (!_buttonEventQueue.push(ButtonPOTEvent(buttonPotInfo.button, buttonPotInfo.pot, buttonPotInfo.potValue, duration))) {
-                                    DEBUG_PRINT("Could not queue POT event for button ", buttonNameString);
-                                }
-                            }
-                        }
-
-                        break;
-                    }
-                }    
-            }
-        }
-        else
-        {
-            bool inAnyRange { false };
-            for (const auto& button : _buttonInfo) {
-                if (button.isInRange(sample)) {
-                    inAnyRange = true;
-                    break;
-                }
-            }
-
-            if (!inAnyRange)
-                return;
-
-            if (!_sampling) {
-                _sampling = true;
-                _samplingTime = 0;
-                _sampleCount = 0;
-                _sampleAvg = _sampleMin = _sampleMax = sample;
-            }
-
-            if (++_sampleCount < maxSampleCount()) {
-                if (sample < _sampleMin)
-                    _sampleMin = sample;
-                
-                if (sample > _sampleMax)
-                    _sampleMax = sample;
-            
-                _sampleAvg += sample;
-                _sampleAvg /= 2;
-            }
-        }
-    }
-
-private:
-    struct ButtonInfo
-    {
-        constexpr ButtonInfo(Button button, uint16_t minSample, uint16_t maxSample)
-            : button { button }
-            , minSample { minSample }
-            , maxSample { maxSample }
-            , alternateButton { button }
-        { }
-
-        constexpr ButtonInfo(Button button, uint16_t minSample, uint16_t maxSample, Button alternateButton)
-            : button { button }
-            , minSample { minSample }
-            , maxSample { maxSample }
-            , alternateButton { alternateButton }
-        { }
-
-        inline bool isInRange(uint16_t value) const
-        {
-            return value >= minSample && value <= maxSample;
-        }
-
-        const Button button;
-        const uint16_t minSample;
-        const uint16_t maxSample;
-        const Button alternateButton;
-    };
-
-    enum class POT : uint8_t { None, Ring, Tip };
-    enum class POTDurationType : uint8_t { Short, Long, Variable };
-
-    struct ButtonPOTInfo
-    {
-        constexpr ButtonPOTInfo(Button button, POT pot, uint8_t potValue, POTDurationType durationType)
-            : button { button }
-            , pot { pot }
-            , potValue { potValue }
-            , durationType { durationType }
-        { }
-
-        const Button button;
-        const POT pot;
-        const uint8_t potValue;
-        const POTDurationType durationType;
-    };
-
-    struct ButtonPOTEvent
-    {
-        constexpr ButtonPOTEvent() = default;
-        constexpr ButtonPOTEvent(Button button, POT pot, uint8_t potValue, uint16_t duration)
-            : button { button }
-            , pot { pot }
-            , potValue { potValue }
-            , duration { duration }
-            , elapsed { 0 }
-        { }
-
-        ButtonPOTEvent(const ButtonPOTEvent&) = default;
-        ButtonPOTEvent& operator=(const ButtonPOTEvent& event) = default;
-
-        inline bool isSet() const { return button != Button::None && pot != POT::None; }
-
-        volatile Button button = Button::None;
-        volatile POT pot = POT::None;
-        volatile uint8_t potValue = 0;
-        volatile uint16_t duration = 0;
-        volatile uint16_t elapsed = 0;
-    };
-
-    static constexpr uint16_t maxSampleValue() { return 890; }
-    static constexpr uint16_t maxSampleCount() { return 600; }
-    static constexpr uint16_t minSampleCount() { return 200; }
-    static constexpr uint16_t alternateFunctionSamplingTimeThreshold() { return 500; }
-    static constexpr uint32_t maxPotResistance() { return 100000; }
-    static constexpr uint8_t maxPotValue() { return 255; }
-    static constexpr uint8_t coolOffDuration() { return 120; }
-
-    static constexpr uint32_t potValueToResistance(uint8_t potValue)
-    {
-        return (maxPotValue() - potValue) * (maxPotResistance() / maxPotValue());
-    }
-    
-    static constexpr uint8_t resistanceToPotValue(uint32_t resistance)
-    {
-        auto result { maxPotValue() - (maxPotValue() * resistance / maxPotResistance()) };
-        if (!result)
-            result += 1;
-        return result;
-    }
-
-    static constexpr uint16_t durationTypeToDuration(POTDurationType durationType)
-    {
-         return durationType == POTDurationType::Long ? 700 : 80;
-    }
-
-    static constexpr const char* buttonName(Button button)
-    {
-        switch (button) {
-            case Button::Select:        return "Select";
-            case Button::Next:          return "Next";
-            case Button::Up:            return "Up";
-            case Button::Prev:          return "Previous";
-            case Button::Down:          return "Down";
-            case Button::Mute:          return "Mute";
-            case Button::OnOff:         return "OnOff";
-            case Button::VolumeUp:      return "Volume Up";
-            case Button::VolumeDown:    return "Volume Down";
-            case Button::AnswerCall:    return "Answer Call";
-            case Button::HangUpCall:    return "Hang Up Call";
-            case Button::AddressBook:   return "Address Book";
-            default:                    return "?";
-        }
-    }
-
-    const ButtonInfo _buttonInfo[6] {
-        // Button                Min ADC value     Max ADC value    Alternate Button on long press
-        { Button::Mute,          0,                100,             Button::OnOff       },
-        { Button::VolumeDown,    160,              220,             Button::HangUpCall  },
-        { Button::VolumeUp,      330,              390,             Button::AnswerCall  },
-        { Button::Select,        490,              550,             Button::AddressBook },
-        { Button::Next,          660,              720,             Button::Up          },
-        { Button::Prev,          770,              830,             Button::Down        },
-    };
-
-    const ButtonPOTInfo _buttonPotInfo[12] {
-        // Button                POT connection type    POT value                         Duration
-        { Button::Select,        POT::Tip,              resistanceToPotValue(1200),       POTDurationType::Short    },
-        { Button::Next,          POT::Tip,              resistanceToPotValue(8000),       POTDurationType::Short    },
-        { Button::Up,            POT::Ring,             resistanceToPotValue(8000),       POTDurationType::Variable },
-        { Button::Prev,          POT::Tip,              resistanceToPotValue(11250),      POTDurationType::Short    },
-        { Button::Down,          POT::Ring,             resistanceToPotValue(11250),      POTDurationType::Variable },
-        { Button::Mute,          POT::Tip,              resistanceToPotValue(3500),       POTDurationType::Short    },
-        { Button::OnOff,         POT::Tip,              resistanceToPotValue(60000),      POTDurationType::Short    },
-        { Button::VolumeUp,      POT::Tip,              resistanceToPotValue(16000),      POTDurationType::Short    },
-        { Button::VolumeDown,    POT::Tip,              resistanceToPotValue(24000),      POTDurationType::Short    },
-        { Button::AnswerCall,    POT::Ring,             resistanceToPotValue(3000),       POTDurationType::Short    },
-        { Button::HangUpCall,    POT::Ring,             resistanceToPotValue(5500),       POTDurationType::Short    },
-        { Button::AddressBook,   POT::Ring,             resistanceToPotValue(1200),       POTDurationType::Short    },
-    };
-
-    bool _sampling = false;
-    uint16_t _samplingTime = 0;
-    uint16_t _sampleCount = 0;
-    uint16_t _sampleMax = 0;
-    uint16_t _sampleMin = 0;
-    uint16_t _sampleAvg = 0;
-
-    Queue<ButtonPOTEvent, 10> _buttonEventQueue;
-    uint8_t _eventCoolOffDuration = coolOffDuration();
-};
+/*
+ * Copyright (C) 2021 adrian_007, adrian-007 on o2 point pl
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#pragma once
+
+#include <avr/io.h>
+
+#include "ADCScanner.h"
+#include "Serial.h"
+#include "Trace.h"
+#include "Flash.h"
+#include "MCP42100.h"
+#include "Clock.h"
+#include "Queue.h"
+#include "TimerWheel.h"
+#include "WorkQueue.h"
+
+class ADCButtons
+{
+public:
+    enum Button : uint8_t
+    {
+        None, // Special value indicating that no button has been pressed.
+        Select,
+        Next,
+        Up,
+        Prev,
+        Down,
+        Mute,
+        OnOff,
+        VolumeUp,
+        VolumeDown,
+        AnswerCall,
+        HangUpCall,
+        AddressBook
+    };
+
+    static ADCButtons& instance()
+    {
+        static ADCButtons instance;
+        return instance;
+    }
+
+    void init()
+    {
+        MCP42100::init();
+
+        static Timer pollTimer { [] { ADCButtons::instance().poll(); } };
+        TimerWheel::start(pollTimer, pollPeriod(), pollPeriod());
+    }
+
+    /**
+     * Timer callback, called every pollPeriod() milliseconds. Events wait in a lane per priority, whenever
+     * a step ends (after its gap) the most urgent lane plays next. A step that started and the rest of its
+     * sequence are never interrupted, coalesced repeats are separate steps and can be.
+     */
+    void poll()
+    {
+        if (_eventCoolOffDuration < _eventGapDuration) {
+            _eventCoolOffDuration += pollPeriod();
+            return;
+        }
+
+        if (!_laneLocked)
+            _activeLane = nextLane();
+
+        auto& lane { _lanes[_activeLane] };
+        auto* event = lane.peek();
+        if (!event)
+            return;
+
+        const ButtonPOTInfo step { buttonPotInfo()[event->step].get() };
+
+        if (event->elapsed > event->duration) {
+            // Event expired
+            MCP42100::setPOT(POT_TIP_SHUTDOWN | POT_RING_SHUTDOWN, 0);
+            TRACE(PotReleased, 0);
+            _eventCoolOffDuration = 0;
+
+            if (event->repeats) {
+                // Coalesced repeat of the same event, play it again after a short release
+                --event->repeats;
+                event->elapsed = 0;
+                _eventGapDuration = sequenceGapDuration();
+                _laneLocked = false;
+            }
+            else {
+                // The rest of a sequence stays in this lane, the gap is only timing
+                _laneLocked = event->continued;
+                _eventGapDuration = step.gap;
+                lane.pop();
+            }
+
+            LOG(BUTTONS, DEBUG, "Pot shut down");
+        }
+        else {
+            if (event->elapsed == 0) {
+                _laneLocked = true;
+
+                if (step.pot == POT::Ring) {
+                    LOG(BUTTONS, DEBUG, "Setting ring POT to 800 ohms");
+        
+                    MCP42100::setPOT(POT_RING_ADDRESS, resistanceToPotValue(800));
+                }
+        
+                LOG(BUTTONS, DEBUG, "Setting tip POT to ", potValueToResistance(step.potValue), FLASH_STRING(" ohms"));
+        
+                MCP42100::setPOT(POT_TIP_ADDRESS, step.potValue);
+                TRACE(PotSet, step.potValue);
+            }
+
+            ++event->elapsed;
+        }
+    }
+
+    /**
+     * Called from ADC interrupt with ladder samples (see ADCScanner), only collects sample statistics - finished
+     * press is classified in the main loop
+     */
+    void newSample(uint16_t sample)
+    {
+        auto noButtonPressed { sample >= maxSampleValue() };
+
+        if (noButtonPressed) {
+            if (_sampling) {
+                _sampling = false;
+
+                if (_sampleCount < minSampleCount())
+                    return;
+
+                TRACE(ButtonPressEnd, 0);
+
+                _press.samplingTime = uint16_t(Clock::millis()) - _samplingStart;
+                _press.sampleCount = _sampleCount;
+                _press.sampleMin = _sampleMin;
+                _press.sampleMax = _sampleMax;
+                _press.sampleAvg = _sampleAvg;
+
+                static Work classifyWork { [] { ADCButtons::instance().classify(); } };
+                WorkQueue::post(classifyWork);
+            }
+        }
+        else
+        {
+            bool inAnyRange { false };
+            for (auto* row { buttonInfo() }; pgm_read(&row->value.button) != Button::None; ++row) {
+                if (ButtonInfo::isInRange(row, sample)) {
+                    inAnyRange = true;
+                    break;
+                }
+            }
+
+            if (!inAnyRange)
+                return;
+
+            if (!_sampling) {
+                _sampling = true;
+                TRACE(ButtonPressStart, 0);
+                _samplingStart = uint16_t(Clock::millis());
+                _sampleCount = 0;
+                _sampleAvg = _sampleMin = _sampleMax = sample;
+            }
+
+            if (++_sampleCount < maxSampleCount()) {
+                if (sample < _sampleMin)
+                    _sampleMin = sample;
+                
+                if (sample > _sampleMax)
+                    _sampleMax = sample;
+            
+                _sampleAvg += sample;
+                _sampleAvg /= 2;
+            }
+        }
+    }
+
+private:
+    /**
+     * ADC range of a button, stored in flash
+     */
+    struct ButtonInfo
+    {
+        Button button;
+        uint16_t minSample;
+        uint16_t maxSample;
+        Button alternateButton;
+
+        /**
+         * Reads only the range from flash, two word loads instead of copying the whole row - used by the ADC interrupt
+         */
+        static inline bool isInRange(const flash<ButtonInfo>* row, uint16_t value)
+        {
+            return value >= pgm_read(&row->value.minSample) && value <= pgm_read(&row->value.maxSample);
+        }
+    };
+
+    enum class POT : uint8_t { None, Ring, Tip };
+    enum class POTDurationType : uint8_t { Short, Long, Variable };
+
+    /**
+     * Lane of the event queue, lower value plays first
+     */
+    enum class Priority : uint8_t { High, Normal, Low };
+
+    /**
+     * One step of button's POT sequence, stored in flash. Consecutive rows of the same button form a sequence,
+     * played back to back - each step is followed by its own gap (release time) before the next one starts.
+     */
+    struct ButtonPOTInfo
+    {
+        Button button;
+        POT pot;
+        uint8_t potValue;
+        POTDurationType durationType;
+        uint8_t gap;
+        Priority priority;
+    };
+
+    /**
+     * Queued step, refers to its buttonPotInfo() row - POT, value and gap are read from flash when played.
+     * Times are in pollPeriod() ticks. Events live only in the main loop (classify() and poll()), none of it is volatile.
+     */
+    struct ButtonPOTEvent
+    {
+        inline bool isRepeatOf(const ButtonPOTEvent& event) const
+        {
+            return step == event.step && duration == event.duration;
+        }
+
+        uint8_t step;
+        uint8_t duration;
+        uint8_t elapsed;
+        uint8_t repeats;
+        // Next buttonPotInfo() row belongs to the same sequence
+        bool continued;
+    };
+
+    /**
+     * Statistics of a finished press, handed over from the ADC interrupt to classify()
+     */
+    struct Press
+    {
+        uint16_t samplingTime = 0;
+        uint16_t sampleCount = 0;
+        uint16_t sampleMin = 0;
+        uint16_t sampleMax = 0;
+        uint16_t sampleAvg = 0;
+    };
+
+    void classify()
+    {
+        Press press;
+        {
+            InterruptGuard ig {};
+            press = _press;
+        }
+
+        // Find out which button was pressed.
+
+        for (auto* row { buttonInfo() }; pgm_read(&row->value.button) != Button::None; ++row) {
+            if (ButtonInfo::isInRange(row, press.sampleAvg)) {
+                const ButtonInfo buttonInfo { row->get() };
+                auto button { press.samplingTime < alternateFunctionSamplingTimeThreshold() ? buttonInfo.button : buttonInfo.alternateButton };
+                TRACE(ButtonClassified, button);
+
+                LOG(BUTTONS, DEBUG, "Sample statistics: min / avg / max: ",
+                    press.sampleMin, FLASH_STRING(" / "), press.sampleAvg, FLASH_STRING(" / "), press.sampleMax,
+                    FLASH_STRING(", sampling time: "), press.samplingTime, FLASH_STRING(", sample count: "), press.sampleCount,
+                    FLASH_STRING(", Button: "), buttonName(button)
+                );
+
+                // Find POT definition (sequence of steps) for given button
+                uint8_t first { 0 };
+                while (pgm_read(&ADCButtons::buttonPotInfo()[first].value.button) != Button::None
+                    && pgm_read(&ADCButtons::buttonPotInfo()[first].value.button) != button)
+                    ++first;
+
+                uint8_t stepCount { 0 };
+                while (button != Button::None && pgm_read(&ADCButtons::buttonPotInfo()[first + stepCount].value.button) == button)
+                    ++stepCount;
+
+                if (!stepCount)
+                    break;
+
+                const auto priority { pgm_read(&ADCButtons::buttonPotInfo()[first].value.priority) };
+                auto& lane { _lanes[uint8_t(priority)] };
+
+                if (priority == Priority::High && dropStaleEvents())
+                    dropLowPriorityEvents();
+
+                auto isLongPress { press.samplingTime >= alternateFunctionSamplingTimeThreshold() * 2 };
+
+                for (uint8_t step { first }; step < first + stepCount; ++step) {
+                    const ButtonPOTInfo buttonPotInfo { ADCButtons::buttonPotInfo()[step].get() };
+
+                    uint8_t duration;
+                    if (buttonPotInfo.durationType == POTDurationType::Variable) {
+                        duration = durationTypeToTicks(isLongPress ? POTDurationType::Long : POTDurationType::Short);
+                    }
+                    else {
+                        duration = durationTypeToTicks(buttonPotInfo.durationType);
+                    }
+
+                    ButtonPOTEvent event { step, duration, 0, 0, step + 1 < first + stepCount };
+
+                    if (step == first) {
+                        // Rapid presses of the same button (e.g. volume) are merged into one queued event
+                        auto* last { lane.back() };
+                        if (last && last->isRepeatOf(event) && last->repeats < maxEventRepeats()) {
+                            ++last->repeats;
+                            break;
+                        }
+
+                        // Head unit would act on half a sequence, it is queued whole or not at all
+                        if (lane.free() < stepCount) {
+                            LOG(BUTTONS, WARNING, "Could not queue POT event for button ", buttonName(button));
+                            break;
+                        }
+                    }
+
+                    lane.push(event);
+                }
+
+                break;
+            }
+        }
+    }
+
+    static constexpr uint8_t pollPeriod() { return 10; }
+    static constexpr uint16_t maxSampleValue() { return 890; }
+    // Press statistics were tuned as 200 and 600 samples at 4 MHz, with the ADC on the ladder alone
+    static constexpr uint16_t maxSampleCount() { return samplesIn(124800); }
+    static constexpr uint16_t minSampleCount() { return samplesIn(41600); }
+    static constexpr uint16_t alternateFunctionSamplingTimeThreshold() { return 500; }
+    static constexpr uint32_t maxPotResistance() { return 100000; }
+    static constexpr uint8_t maxPotValue() { return 255; }
+    static constexpr uint8_t coolOffDuration() { return 120; }
+    static constexpr uint8_t sequenceGapDuration() { return 40; }
+    static constexpr uint8_t maxEventRepeats() { return 255; }
+
+    /**
+     * Whether a high priority press drops queued low priority events, volume changes queued before muting,
+     * power off or a call make no sense after it
+     */
+    static constexpr bool dropStaleEvents() { return true; }
+
+    uint8_t nextLane() const
+    {
+        for (uint8_t lane { 0 }; lane < sizeof(_lanes) / sizeof(_lanes[0]); ++lane) {
+            if (!_lanes[lane].empty())
+                return lane;
+        }
+
+        return _activeLane;
+    }
+
+    /**
+     * Empties the low priority lane, except for a step that is playing - it finishes without its repeats
+     */
+    void dropLowPriorityEvents()
+    {
+        auto& lane { _lanes[uint8_t(Priority::Low)] };
+        const auto* playing { _laneLocked && _activeLane == uint8_t(Priority::Low) ? lane.peek() : nullptr };
+
+        ButtonPOTEvent kept {};
+        if (playing) {
+            kept = *playing;
+            kept.repeats = 0;
+        }
+
+        if (lane.size() > (playing ? 1 : 0))
+            LOG(BUTTONS, DEBUG, "Dropping stale low priority events: ", lane.size());
+
+        lane.clear();
+        if (playing)
+            lane.push(kept);
+    }
+
+    static constexpr uint16_t samplesIn(uint32_t microseconds)
+    {
+        return uint16_t(uint64_t(ADCScanner::ladderSampleFrequency()) * microseconds / 1000000ULL);
+    }
+
+    static constexpr uint32_t potValueToResistance(uint8_t potValue)
+    {
+        return (maxPotValue() - potValue) * (maxPotResistance() / maxPotValue());
+    }
+    
+    static constexpr uint8_t resistanceToPotValue(uint32_t resistance)
+    {
+        auto result { maxPotValue() - (maxPotValue() * resistance / maxPotResistance()) };
+        if (!result)
+            result += 1;
+        return result;
+    }
+
+    static constexpr uint16_t durationTypeToDuration(POTDurationType durationType)
+    {
+         return durationType == POTDurationType::Long ? 700 : 80;
+    }
+
+    static constexpr uint8_t durationTypeToTicks(POTDurationType durationType)
+    {
+        return durationTypeToDuration(durationType) / pollPeriod();
+    }
+
+    static const flash<char>* buttonName(Button button)
+    {
+        switch (button) {
+            case Button::Select:        return FLASH_STRING("Select");
+            case Button::Next:          return FLASH_STRING("Next");
+            case Button::Up:            return FLASH_STRING("Up");
+            case Button::Prev:          return FLASH_STRING("Previous");
+            case Button::Down:          return FLASH_STRING("Down");
+            case Button::Mute:          return FLASH_STRING("Mute");
+            case Button::OnOff:         return FLASH_STRING("OnOff");
+            case Button::VolumeUp:      return FLASH_STRING("Volume Up");
+            case Button::VolumeDown:    return FLASH_STRING("Volume Down");
+            case Button::AnswerCall:    return FLASH_STRING("Answer Call");
+            case Button::HangUpCall:    return FLASH_STRING("Hang Up Call");
+            case Button::AddressBook:   return FLASH_STRING("Address Book");
+            default:                    return FLASH_STRING("?");
+        }
+    }
+
+    static const flash<ButtonInfo>* buttonInfo()
+    {
+        static const flash<ButtonInfo> PROGMEM buttonInfo[] {
+            // Button                Min ADC value     Max ADC value    Alternate Button on long press
+            { Button::Mute,          0,                100,             Button::OnOff       },
+            { Button::VolumeDown,    160,              220,             Button::HangUpCall  },
+            { Button::VolumeUp,      330,              390,             Button::AnswerCall  },
+            { Button::Select,        490,              550,             Button::AddressBook },
+            { Button::Next,          660,              720,             Button::Up          },
+            { Button::Prev,          770,              830,             Button::Down        },
+            { Button::None,          0,                0,               Button::None        },
+        };
+
+        return buttonInfo;
+    }
+
+    /**
+     * Consecutive rows of the same button are one sequence, whatever their gaps. Steps usually use
+     * sequenceGapDuration() (the shortest release head unit still registers) between them and coolOffDuration()
+     * after the last one, all of them with the same priority, e.g.:
+     *     { Button::X,  POT::Tip,  resistanceToPotValue(3500),  POTDurationType::Short,  sequenceGapDuration(),  Priority::Normal },
+     *     { Button::X,  POT::Tip,  resistanceToPotValue(1200),  POTDurationType::Short,  coolOffDuration(),      Priority::Normal },
+     *
+     * High priority is for actions that must not wait (mute, power, calls), Low for volume steps that may be dropped.
+     */
+    static const flash<ButtonPOTInfo>* buttonPotInfo()
+    {
+        static const flash<ButtonPOTInfo> PROGMEM buttonPotInfo[] {
+            // Button                POT connection type    POT value                         Duration                    Gap after             Priority
+            { Button::Select,        POT::Tip,              resistanceToPotValue(1200),       POTDurationType::Short,     coolOffDuration(),     Priority::Normal },
+            { Button::Next,          POT::Tip,              resistanceToPotValue(8000),       POTDurationType::Short,     coolOffDuration(),     Priority::Normal },
+            { Button::Up,            POT::Ring,             resistanceToPotValue(8000),       POTDurationType::Variable,  coolOffDuration(),     Priority::Normal },
+            { Button::Prev,          POT::Tip,              resistanceToPotValue(11250),      POTDurationType::Short,     coolOffDuration(),     Priority::Normal },
+            { Button::Down,          POT::Ring,             resistanceToPotValue(11250),      POTDurationType::Variable,  coolOffDuration(),     Priority::Normal },
+            { Button::Mute,          POT::Tip,              resistanceToPotValue(3500),       POTDurationType::Short,     coolOffDuration(),     Priority::High },
+            { Button::OnOff,         POT::Tip,              resistanceToPotValue(60000),      POTDurationType::Short,     coolOffDuration(),     Priority::High },
+            { Button::VolumeUp,      POT::Tip,              resistanceToPotValue(16000),      POTDurationType::Short,     coolOffDuration(),     Priority::Low },
+            { Button::VolumeDown,    POT::Tip,              resistanceToPotValue(24000),      POTDurationType::Short,     coolOffDuration(),     Priority::Low },
+            { Button::AnswerCall,    POT::Ring,             resistanceToPotValue(3000),       POTDurationType::Short,     coolOffDuration(),     Priority::High },
+            { Button::HangUpCall,    POT::Ring,             resistanceToPotValue(5500),       POTDurationType::Short,     coolOffDuration(),     Priority::High },
+            { Button::AddressBook,   POT::Ring,             resistanceToPotValue(1200),       POTDurationType::Short,     coolOffDuration(),     Priority::Normal },
+            { Button::None,          POT::None,             0,                                POTDurationType::Short,     0,                     Priority::Normal },
+        };
+
+        return buttonPotInfo;
+    }
+
+    bool _sampling = false;
+    uint16_t _samplingStart = 0;
+    uint16_t _sampleCount = 0;
+    uint16_t _sampleMax = 0;
+    uint16_t _sampleMin = 0;
+    uint16_t _sampleAvg = 0;
+
+    Press _press;
+
+    Queue<ButtonPOTEvent, 4> _lanes[uint8_t(Priority::Low) + 1];
+    uint8_t _activeLane = 0;
+    bool _laneLocked = false;
+    // Wider than the gaps it is compared with, it grows by pollPeriod() and must not wrap before reaching any of them
+    uint16_t _eventCoolOffDuration = coolOffDuration();
+    uint8_t _eventGapDuration = coolOffDuration();
+};
@@ -0,0 +1,287 @@
+/*
+ * Copyright (C) 2021 adrian_007, adrian-007 on o2 point pl
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+
+#pragma once
+
+#include <avr/io.h>
+#include <stdint.h>
+
+#include "Board.h"
+#include "InterruptGuard.h"
+#include "TimerWheel.h"
+#include "WorkQueue.h"
+
+/**
+ * Auxiliary ADC input sampled by ADCScanner. Objects are owned by the modules using them and should have static
+ * storage duration, like Timer.
+ */
+struct ADCChannel
+{
+    /**
+     * Called from the main loop with the average of 2^averagingShift conversions
+     */
+    using Consumer = void (*)(uint16_t average);
+
+    constexpr ADCChannel(uint8_t mux, uint16_t period, uint8_t averagingShift, Consumer consumer)
+        : mux { mux }, period { period }, averagingShift { averagingShift }, consumer { consumer }
+    { }
+
+    ADCChannel(const ADCChannel&) = delete;
+    ADCChannel& operator=(const ADCChannel&) = delete;
+
+    const uint8_t mux;
+    // Milliseconds between averages, rounded up to ADCScanner::requestPeriod()
+    const uint16_t period;
+    // At most 6, the sum is 16 bit
+    const uint8_t averagingShift;
+    const Consumer consumer;
+
+    uint16_t elapsed = 0;
+    volatile bool requested = false;
+    volatile bool ready = false;
+    uint8_t count = 0;
+    uint16_t sum = 0;
+    uint16_t average = 0;
+    ADCChannel* next = nullptr;
+};
+
+/**
+ * Shares the ADC between the steering wheel ladder (ADC7) and auxiliary channels. The converter runs free at
+ * adcFrequency(), the interrupt takes the result and selects the input of the conversion after next, the next
+ * one has started already with the previous selection.
+ *
+ * Every auxSlotInterval() conversions begin with an auxiliary slot of auxSlotLength() back to back conversions,
+ * the rest belong to the ladder, so ladder samples come at a fixed rate, ladderSampleFrequency(), whatever the
+ * auxiliary channels do. The first conversion of a slot follows the switch from the ladder and is dropped: the
+ * sample and hold (and the internal reference, for bandgapMux()) has not settled yet. A channel is requested
+ * by a timer once its period passes and then takes the auxiliary slots until its average is complete,
+ * requested channels are served round robin. A slot nobody requested converts the ladder and is dropped.
+ */
+class ADCScanner
+{
+public:
+    ADCScanner() = delete;
+
+    /**
+     * ADC runs free at the fastest clock not above maxAdcFrequency(), a conversion takes adcCyclesPerConversion()
+     */
+    static constexpr uint32_t maxAdcFrequency() { return 62500; }
+    static constexpr uint8_t adcClockSelect() { return Board::adcClockSelect(maxAdcFrequency()); }
+    static constexpr uint32_t adcFrequency() { return Board::adcFrequency(adcClockSelect()); }
+    static constexpr uint8_t adcCyclesPerConversion() { return 13; }
+
+    static constexpr uint8_t auxSlotInterval() { return 16; }
+    static constexpr uint8_t auxSlotLength() { return 2; }
+
+    /**
+     * Average rate, auxSlotLength() conversions in auxSlotInterval() are missing
+     */
+    static constexpr uint32_t ladderSampleFrequency()
+    {
+        return adcFrequency() * (auxSlotInterval() - auxSlotLength())
+            / (uint32_t(adcCyclesPerConversion()) * auxSlotInterval());
+    }
+
+    static constexpr uint8_t ladderMux() { return 7; }
+
+    /**
+     * Internal 1.1 V reference measured against AVCC, gives the supply voltage. The reference is 1.0 - 1.2 V
+     * from part to part, readings need calibration against a meter to be better than 10 %.
+     */
+    static constexpr uint8_t bandgapMux() { return 0x0E; }
+
+    static constexpr uint8_t requestPeriod() { return 50; }
+
+    /**
+     * Channels may be added before or after init()
+     */
+    static void add(ADCChannel& channel)
+    {
+        InterruptGuard ig {};
+        channel.next = channels();
+        channels() = &channel;
+    }
+
+    static void init()
+    {
+        // ADMUX 7:6 = 01 - set voltage reference to AVCC with external capacitor at AREF pin
+        ADMUX = (1 << REFS0) | ladderMux();
+
+        ADCSRA |= (1 << ADEN) | (1 << ADSC) | (1 << ADATE) | (1 << ADIE) | (adcClockSelect() << ADPS0);
+
+        static Timer requestTimer { request };
+        TimerWheel::start(requestTimer, requestPeriod(), requestPeriod());
+    }
+
+    /**
+     * Called from ADC interrupt with the result. Returns true for a ladder sample, auxiliary results are
+     * collected here and handed to their consumers from the main loop.
+     *
+     * The selection two conversions ahead holds as long as the interrupt is not late by a whole conversion,
+     * it has the highest priority for that reason (see main.cpp).
+     */
+    static bool complete(uint16_t sample)
+    {
+        const Conversion conversion { converting() };
+        converting() = selected();
+        selected() = schedule();
+        ADMUX = (1 << REFS0) | (selected().channel ? selected().channel->mux : ladderMux());
+
+        ADCChannel* channel { conversion.channel };
+        if (!channel)
+            return true;
+
+        if (conversion.settling || channel == &spare())
+            return false;
+
+        channel->sum += sample;
+        if (++channel->count >> channel->averagingShift) {
+            channel->average = channel->sum >> channel->averagingShift;
+            channel->ready = true;
+            channel->requested = false;
+            burst() = nullptr;
+
+            static Work deliverWork { deliver };
+            WorkQueue::post(deliverWork);
+        }
+
+        return false;
+    }
+
+private:
+    struct Conversion
+    {
+        // nullptr for the ladder
+        ADCChannel* channel;
+        // First conversion after switching the input, dropped
+        bool settling;
+    };
+
+    /**
+     * Conversion for the next slot
+     */
+    static Conversion schedule()
+    {
+        static_assert(auxSlotInterval() >= auxSlotLength() + 2, "Auxiliary slots closer than the conversion pipeline");
+
+        const uint8_t current { slot() };
+        slot() = (current + 1) % auxSlotInterval();
+
+        if (current >= auxSlotLength())
+            return { nullptr, false };
+
+        if (current == 0 && !burst()) {
+            // Round robin: start looking after the channel served last
+            ADCChannel* candidate { lastServed() };
+            for (ADCChannel* channel { channels() }; channel; channel = channel->next) {
+                candidate = candidate && candidate->next ? candidate->next : channels();
+                if (candidate->requested) {
+                    candidate->count = 0;
+                    candidate->sum = 0;
+                    burst() = lastServed() = candidate;
+                    break;
+                }
+            }
+        }
+
+        return { burst() ? burst() : &spare(), current == 0 };
+    }
+
+    /**
+     * Timer callback, requests channels whose period passed
+     */
+    static void request()
+    {
+        for (ADCChannel* channel { channels() }; channel; channel = channel->next) {
+            channel->elapsed += requestPeriod();
+            if (channel->elapsed >= channel->period && !channel->requested) {
+                channel->elapsed = 0;
+                channel->requested = true;
+            }
+        }
+    }
+
+    static void deliver()
+    {
+        for (ADCChannel* channel { channels() }; channel; channel = channel->next) {
+            uint16_t average;
+            {
+                InterruptGuard ig {};
+                if (!channel->ready)
+                    continue;
+
+                channel->ready = false;
+                average = channel->average;
+            }
+
+            channel->consumer(average);
+        }
+    }
+
+    /**
+     * Auxiliary slot nobody requested, converts the ladder without using the result
+     */
+    static ADCChannel& spare()
+    {
+        static ADCChannel spare { ladderMux(), 0, 0, nullptr };
+        return spare;
+    }
+
+    static ADCChannel*& channels()
+    {
+        static ADCChannel* channels { nullptr };
+        return channels;
+    }
+
+    static Conversion& converting()
+    {
+        static Conversion converting { nullptr, false };
+        return converting;
+    }
+
+    static Conversion& selected()
+    {
+        static Conversion selected { nullptr, false };
+        return selected;
+    }
+
+    static ADCChannel*& burst()
+    {
+        static ADCChannel* burst { nullptr };
+        return burst;
+    }
+
+    static ADCChannel*& lastServed()
+    {
+        static ADCChannel* lastServed { nullptr };
+        return lastServed;
+    }
+
+    /**
+     * Position of the next conversion in the auxSlotInterval() cycle, the auxiliary slot starts at 0
+     */
+    static uint8_t& slot()
+    {
+        static uint8_t slot { 0 };
+        return slot;
+    }
+};
+
+static_assert(ADCScanner::adcFrequency() >= Board::adcMinFrequency() && ADCScanner::adcFrequency() <= Board::adcMaxFrequency(),
+    "F_CPU gives no ADC clock usable for 10 bit conversions");
@@ -0,0 +1,185 @@
+/*
+ * Copyright (C) 2021 adrian_007, adrian-007 on o2 point pl
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+
+#pragma once
+
+#ifndef F_CPU
+# error "F_CPU not defined"
+#endif
+
+#if defined(ENABLE_ADC_TRACE) && defined(ENABLE_UART_LOGGING)
+# error "ADC trace uses UART exclusively, disable ENABLE_UART_LOGGING"
+#endif
+
+#ifdef ENABLE_ADC_TRACE
+
+#include <avr/io.h>
+#include <stdint.h>
+
+#include "Board.h"
+#include "InterruptGuard.h"
+
+/**
+ * Raw ADC capture for classifier tuning (ENABLE_ADC_TRACE), decoded on the host by tools/adctrace.py.
+ *
+ * Every sample from ADC_vect is delta encoded into a RAM ring which USART_UDRE_vect drains at traceBaudRate().
+ * Stream records:
+ *   d                - int8 delta to the previous sample, -127..127
+ *   0x80 lo hi       - absolute 10-bit sample (hi <= 0x03), every keySampleInterval() samples and when delta
+ *                      does not fit
+ *   0x80 n 0xFF      - n samples (saturated at 255) were dropped because the ring was full, absolute sample follows
+ */
+class ADCTrace
+{
+public:
+    ADCTrace() = delete;
+
+    static constexpr uint32_t traceBaudRate() { return 250000UL; }
+    static constexpr uint8_t keySampleInterval() { return 255; }
+
+    static void init()
+    {
+        static_assert(Board::uartErrorPpm(traceBaudRate()) <= Board::uartMaxErrorPpm(), "Trace baud rate cannot be generated from F_CPU accurately enough");
+
+        UBRR0 = Board::uartDivisor(traceBaudRate());
+        UCSR0A |= (1 << U2X0);
+        UCSR0B |= (1 << TXEN0);
+        UCSR0C |= (3 << UCSZ00);
+
+        enabled() = true;
+    }
+
+    /**
+     * Called from ADC interrupt
+     */
+    static void record(uint16_t sample)
+    {
+        if (!enabled())
+            return;
+
+        auto& state { encoder() };
+        int16_t delta { int16_t(sample - state.previous) };
+        bool key { state.dropped || state.sinceKey >= keySampleInterval() || delta < -127 || delta > 127 };
+
+        uint8_t needed { uint8_t(key ? (state.dropped ? 6 : 3) : 1) };
+        if (ring().free() < needed) {
+            if (state.dropped < 255)
+                ++state.dropped;
+            return;
+        }
+
+        if (key) {
+            if (state.dropped) {
+                ring().push(0x80);
+                ring().push(state.dropped);
+                ring().push(0xFF);
+                state.dropped = 0;
+            }
+
+            ring().push(0x80);
+            ring().push(uint8_t(sample));
+            ring().push(uint8_t(sample >> 8));
+            state.sinceKey = 0;
+        }
+        else {
+            ring().push(uint8_t(int8_t(delta)));
+            ++state.sinceKey;
+        }
+
+        state.previous = sample;
+
+        // Wake up the transmitter
+        UCSR0B |= (1 << UDRIE0);
+    }
+
+    /**
+     * Called from USART_UDRE_vect
+     */
+    static void transmit()
+    {
+        uint8_t byte;
+        if (ring().pop(byte)) {
+            UDR0 = byte;
+        }
+        else {
+            UCSR0B &= ~(1 << UDRIE0);
+        }
+    }
+
+private:
+    struct Encoder
+    {
+        uint16_t previous = 0;
+        uint8_t sinceKey = keySampleInterval();
+        uint8_t dropped = 0;
+    };
+
+    /**
+     * Byte ring shared by ADC (producer) and UDRE (consumer) interrupts, which never nest
+     */
+    template<uint8_t Capacity>
+    class Ring
+    {
+        static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+    public:
+        uint8_t free() const { return Capacity - uint8_t(_head - _tail); }
+
+        void push(uint8_t byte)
+        {
+            _data[_head & (Capacity - 1)] = byte;
+            ++_head;
+        }
+
+        bool pop(uint8_t& byte)
+        {
+            if (_head == _tail)
+                return false;
+
+            byte = _data[_tail & (Capacity - 1)];
+            ++_tail;
+            return true;
+        }
+
+    private:
+        uint8_t _data[Capacity];
+        uint8_t _head = 0;
+        uint8_t _tail = 0;
+    };
+
+    static volatile bool& enabled()
+    {
+        static volatile bool enabled { false };
+        return enabled;
+    }
+
+    static Encoder& encoder()
+    {
+        static Encoder encoder;
+        return encoder;
+    }
+
+    static Ring<128>& ring()
+    {
+        static Ring<128> ring;
+        return ring;
+    }
+};
+
+#endif
@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2021 adrian_007, adrian-007 on o2 point pl
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+
+#pragma once
+
+#ifndef F_CPU
+# error "F_CPU not defined"
+#endif
+
+#include <stdint.h>
+
+/**
+ * Clock profile of the board. Prescalers, divisors and compare values of the peripherals are derived here from
+ * F_CPU and the frequency each user needs, the users static_assert on the error they can tolerate. Moving to
+ * another crystal (or the 8 MHz internal RC oscillator) is then only a matter of changing F_CPU.
+ */
+class Board
+{
+public:
+    Board() = delete;
+
+    static constexpr uint32_t cpuFrequency() { return F_CPU; }
+
+    /**
+     * Deviation of a period of cycles CPU cycles from the period of frequency, in ppm
+     */
+    static constexpr uint32_t errorPpm(uint32_t cycles, uint32_t frequency)
+    {
+        const uint64_t actual { uint64_t(cycles) * frequency };
+        const uint64_t difference { actual > cpuFrequency() ? actual - cpuFrequency() : cpuFrequency() - actual };
+        return uint32_t(difference * 1000000ULL / cpuFrequency());
+    }
+
+    /**
+     * Timer0 and Timer1 share prescalers and their CSn2:0 encoding, 0 (timer stopped) is not used here
+     */
+    static constexpr uint16_t timerPrescaler(uint8_t clockSelect)
+    {
+        return clockSelect <= 1 ? 1 : clockSelect == 2 ? 8 : clockSelect == 3 ? 64 : clockSelect == 4 ? 256 : 1024;
+    }
+
+    /**
+     * Timer counts closest to the period of frequency
+     */
+    static constexpr uint32_t timerCounts(uint8_t clockSelect, uint32_t frequency)
+    {
+        const uint32_t divisor { uint32_t(timerPrescaler(clockSelect)) * frequency };
+        return (cpuFrequency() + divisor / 2) / divisor;
+    }
+
+    /**
+     * Smallest prescaler (finest resolution) for which the period of frequency fits maxCounts timer counts
+     */
+    static constexpr uint8_t timerClockSelect(uint32_t frequency, uint32_t maxCounts)
+    {
+        uint8_t clockSelect { 1 };
+        while (clockSelect < 5 && timerCounts(clockSelect, frequency) > maxCounts)
+            ++clockSelect;
+        return clockSelect;
+    }
+
+    /**
+     * Largest prescaler (cheapest arithmetic on counts) that still gives minCounts timer counts per period of frequency
+     */
+    static constexpr uint8_t timerCoarsestClockSelect(uint32_t frequency, uint32_t minCounts)
+    {
+        uint8_t clockSelect { 5 };
+        while (clockSelect > 1 && timerCounts(clockSelect, frequency) < minCounts)
+            --clockSelect;
+        return clockSelect;
+    }
+
+    static constexpr uint32_t timerErrorPpm(uint8_t clockSelect, uint32_t frequency)
+    {
+        return errorPpm(timerPrescaler(clockSelect) * timerCounts(clockSelect, frequency), frequency);
+    }
+
+    /**
+     * ADC prescaler is 2^ADPS2:0, the fastest clock not above maxFrequency is used, or the slowest one if none is
+     */
+    static constexpr uint8_t adcClockSelect(uint32_t maxFrequency)
+    {
+        uint8_t clockSelect { 1 };
+        while (clockSelect < 7 && (cpuFrequency() >> clockSelect) > maxFrequency)
+            ++clockSelect;
+        return clockSelect;
+    }
+
+    static constexpr uint32_t adcFrequency(uint8_t clockSelect) { return cpuFrequency() >> clockSelect; }
+
+    /**
+     * Successive approximation needs an ADC clock of 50 - 200 kHz for full 10 bit resolution
+     */
+    static constexpr uint32_t adcMinFrequency() { return 50000; }
+    static constexpr uint32_t adcMaxFrequency() { return 200000; }
+
+    /**
+     * UBRR0 for double speed mode (U2X0), rounded to the closest baud rate
+     */
+    static constexpr uint16_t uartDivisor(uint32_t baudRate)
+    {
+        return uint16_t((cpuFrequency() + 4UL * baudRate) / (8UL * baudRate) - 1UL);
+    }
+
+    static constexpr uint32_t uartErrorPpm(uint32_t baudRate)
+    {
+        return errorPpm(8UL * (uartDivisor(baudRate) + 1UL), baudRate);
+    }
+
+    /**
+     * Receivers sample in the middle of a bit, 1 % leaves margin for the other side's error over a 10 bit frame
+     */
+    static constexpr uint32_t uartMaxErrorPpm() { return 10000; }
+
+    /**
+     * TWBR with prescaler 1, rounded up so the bus never runs faster than frequency
+     */
+    static constexpr uint16_t twiBitRate(uint32_t frequency)
+    {
+        return uint16_t((cpuFrequency() - 16UL * frequency + 2UL * frequency - 1UL) / (2UL * frequency));
+    }
+
+    static constexpr uint32_t twiFrequency(uint16_t bitRate) { return cpuFrequency() / (16UL + 2UL * bitRate); }
+};
@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2021 adrian_007, adrian-007 on o2 point pl
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+
+#pragma once
+
+#ifndef F_CPU
+# error "F_CPU not defined"
+#endif
+
+#include <avr/io.h>
+#include <stdint.h>
+
+#include "Board.h"
+#include "InterruptGuard.h"
+
+/**
+ * Free running monotonic clock based on Timer1, the only source of time for periodic work (see TimerWheel).
+ * Timer1 runs in CTC mode with the coarsest prescaler giving minCountsPerMillisecond() (8 at 4 MHz) and overflows
+ * every millisecond, tick() must be called from TIMER1_COMPA_vect.
+ */
+class Clock
+{
+public:
+    Clock() = delete;
+
+    static constexpr uint16_t tickFrequency() { return 1000; }
+
+    /**
+     * 2 us resolution of micros()
+     */
+    static constexpr uint16_t minCountsPerMillisecond() { return 500; }
+
+    static constexpr uint8_t clockSelect() { return Board::timerCoarsestClockSelect(tickFrequency(), minCountsPerMillisecond()); }
+    static constexpr uint16_t prescaler() { return Board::timerPrescaler(clockSelect()); }
+    static constexpr uint16_t countsPerMillisecond() { return Board::timerCounts(clockSelect(), tickFrequency()); }
+
+    /**
+     * Nothing depends on wall time, 0.05 % drift keeps baud rate crystals (e.g. 14.7456 MHz) usable
+     */
+    static constexpr uint32_t maxErrorPpm() { return 500; }
+
+    static void init()
+    {
+        static_assert(Board::timerCounts(clockSelect(), tickFrequency()) <= UINT16_MAX / 16, "F_CPU too high for 16 bit fineTicks() arithmetic");
+        static_assert(countsPerMillisecond() > 1, "F_CPU too low for a millisecond tick");
+        static_assert(Board::timerErrorPpm(clockSelect(), tickFrequency()) <= maxErrorPpm(), "Millisecond tick cannot be generated from F_CPU accurately enough");
+
+        // CTC mode
+        TCCR1A = 0;
+        TCCR1B = (1 << WGM12) | (clockSelect() << CS10);
+        TCNT1 = 0;
+        OCR1A = countsPerMillisecond() - 1;
+        // Enable COMPA interrupt
+        TIMSK1 |= (1 << OCIE1A);
+    }
+
+    /**
+     * Advances the clock by a millisecond, returns lower 16 bits of the new time
+     */
+    static inline uint16_t tick()
+    {
+        return ++counter();
+    }
+
+    static uint32_t millis()
+    {
+        InterruptGuard ig {};
+        return counter();
+    }
+
+    static uint32_t micros()
+    {
+        InterruptGuard ig {};
+
+        uint32_t ms { counter() };
+        uint16_t counts { TCNT1 };
+
+        // Counter has already wrapped, but the interrupt was not serviced yet
+        if ((TIFR1 & (1 << OCF1A)) && counts < countsPerMillisecond() - 1) {
+            ++ms;
+        }
+
+        return ms * 1000UL + uint32_t(counts) * 1000UL / countsPerMillisecond();
+    }
+
+    /**
+     * Time in 1/16 ms, wraps every 4.096 s - cheap timestamp for tracepoints (see Trace.h)
+     */
+    static uint16_t fineTicks()
+    {
+        InterruptGuard ig {};
+
+        uint16_t ms { uint16_t(counter()) };
+        uint16_t counts { TCNT1 };
+
+        // Counter has already wrapped, but the interrupt was not serviced yet
+        if ((TIFR1 & (1 << OCF1A)) && counts < countsPerMillisecond() - 1) {
+            ++ms;
+        }
+
+        return uint16_t(ms << 4) | uint16_t(counts * 16U / countsPerMillisecond());
+    }
+
+private:
+    static volatile uint32_t& counter()
+    {
+        static volatile uint32_t counter { 0 };
+        return counter;
+    }
+};
@@ -1,321 +1,405 @@
-/*
- * Copyright (C) 2021 adrian_007, adrian-007 on o2 point pl
- *
- * This program is free software; you can redistribute it and/or modify
- * it under the terms of the GNU General Public License as published by
- * the Free Software Foundation; either version 3 of the License, or
- * (at your option) any later version.
- *
- * This program is distributed in the hope that it will be useful,
- * but WITHOUT ANY WARRANTY; without even the implied warranty of
- * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
- * GNU General Public License for more details.
- *
- * You should have received a copy of the GNU General Public License
- * along with this program; if not, write to the Free Software
- * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
- */
-
-#pragma once
-
-#include <avr/io.h>
-#include <util/delay.h>
-
-#include "InterruptGuard.h"
-#include "Serial.h"
-
-#define DS_PORT       PORTD
-#define DS_DDR        DDRD
-#define DS_PIN        PIND
-#define DS_PIN_NUM    PIND3
-
-class DS18B20
-{
-public:
-    static void init()
-    {
-        if (!oneWireInit()) {
-            DEBUG_PRINT(" Sensor not present");
-            return;
-        }
-
-        uint8_t sp[9] { 0 };
-        bool changeResolution { true };
-
-        if (readScratchPad(sp)) {
-            auto resolution { sp[4] >> 5 };
-            
-            switch (resolution) {
-                case 0:
-                    DEBUG_PRINT(" Sensor present, resolution: ", 9, "-bits");
-                    changeResolution = false;
-                    break;
-                case 1:
-                    DEBUG_PRINT(" Sensor present, resolution: ", 10, "-bits");
-                    break;
-                case 2:
-                    DEBUG_PRINT(" Sensor present, resolution: ", 11, "-bits");
-                    break;
-                case 3:
-                    DEBUG_PRINT(" Sensor present, resolution: ", 12, "-bits");
-                    break;
-                default:
-                    DEBUG_PRINT(" Sensor present, unknown resolution - ", ", read value: ", resolution);
-                    break;
-            }
-            
-        }
-        else {
-            DEBUG_PRINT(" Sensor not present, cannot read scratchpad");
-        }
-
-        if (changeResolution) {
-            // 9-bit resolution
-            writeScratchPad(0xFF, 0xFF, 0x00);
-            commitScratchPad();    
-        }
-    }
-
-    /**
-     * Method should be called every second
-     */
-    static void poll()
-    {
-        constexpr uint8_t samplesPerMinute { 12 };
-        constexpr uint8_t ticksThreshold { 60 / samplesPerMinute };
-
-        static volatile bool converting { false };
-        static volatile uint8_t ticks { ticksThreshold };
-
-        if (++ticks < ticksThreshold)
-            return;
-
-        if (!converting) {
-            converting = startConversion();
-            
-            if (!converting) {
-                lastTemperatureValue() = 90;
-            }
-        }
-        else {
-            converting = false;
-            ticks = 0;
-
-            lastTemperatureValue() = readTemp();
-        }
-    }
-
-    static volatile int8_t& lastTemperatureValue()
-    {
-        static volatile int8_t lastTemp = 90;
-        return lastTemp;
-    }
-
-private:
-    enum Commands : uint8_t
-    {
-        SkipROM            = 0xCC,
-        StartConversion    = 0x44,
-        ReadScratchPad     = 0xBE,
-        WriteScratchPad    = 0x4E,
-        CommitScratchPad   = 0x48
-    };
-
-    static int8_t readTemp()
-    {
-        uint8_t sp[9] { 0 };
-        if (!readScratchPad(sp))
-            return 127;
-
-        int16_t temp = ((int16_t)(sp[1] << 8) + sp[0]) / 16;
-        return (int8_t)(temp);
-    }
-
-    static bool startConversion()
-    {
-        if (!oneWireInit()) {
-            DEBUG_PRINT("Could not initialize 1-Wire reset pulse prior to ", "starting conversion");
-            return false;
-        }
-
-        oneWireWrite(Commands::SkipROM, Commands::StartConversion);
-        oneWireStrongPullup();
-        return true;
-    }
-
-    static bool readScratchPad(uint8_t scratchPad[9])
-    {
-        if (!oneWireInit()) {
-            DEBUG_PRINT("Could not initialize 1-Wire reset pulse prior to ", "reading scratch pad data");
-            return false;
-        }
-
-        oneWireWrite(Commands::SkipROM, Commands::ReadScratchPad);
-
-        scratchPad[0] = oneWireRead();
-        scratchPad[1] = oneWireRead();
-        scratchPad[2] = oneWireRead();
-        scratchPad[3] = oneWireRead();
-        scratchPad[4] = oneWireRead();
-        scratchPad[5] = oneWireRead();
-        scratchPad[6] = oneWireRead();
-        scratchPad[7] = oneWireRead();
-        scratchPad[8] = oneWireRead();
-
-        return calculateCRC(&scratchPad[0], 8) == scratchPad[8];
-    }
-
-    static bool writeScratchPad(uint8_t th, uint8_t tl, uint8_t config)
-    {
-        if (!oneWireInit()) {
-            DEBUG_PRINT("Could not initialize 1-Wire reset pulse prior to ", "writing scratch pad data");
-            return false;
-        }
-
-        oneWireWrite(Commands::SkipROM, Commands::WriteScratchPad, th, tl, config);
-        return true;
-    }
-
-    static bool commitScratchPad()
-    {
-        if (!oneWireInit()) {
-            DEBUG_PRINT("Could not initialize 1-Wire reset pulse prior to ", "commiting scratch pad data to EEPROM");
-            return false;
-        }
-
-        oneWireWrite(Commands::SkipROM, Commands::CommitScratchPad);
-        oneWireStrongPullup();
-        _delay_ms(15);
-        return true;
-    }
-
-    inline static void oneWireStrongPullup()
-    {
-        pullUp();
-        tx();
-    }
-
-    static bool oneWireInit()
-    {
-        InterruptGuard ig {};
-
-        pullUp();
-        tx();
-        pullDown();
-
-        _delay_us(500); // 480 us + 20 us of margin
-        rx();
-        _delay_us(80); // 60 us + 20 us of margin
-        
-        bool presence { false };
-        uint16_t remainingSleep { 500 };
-
-        while (remainingSleep > 0) {
-            if (!presence && !pin()) {
-                presence = true;
-            }
-
-            --remainingSleep;
-            _delay_us(1);
-        }
-
-        pullUp();
-        tx();
-
-        return presence;
-    }
-    
-    static void oneWireWrite(auto value)
-    {
-        static_assert(sizeof(value) == 1, "You may write at most one byte at a time");
-
-        constexpr auto writeBit = [](bool bit) {
-            InterruptGuard ig {};
-
-            pullDown();
-            bit ? _delay_us(8) : _delay_us(80);
-
-            pullUp();
-            bit ? _delay_us(80) : _delay_us(8);
-        };
-
-        pullUp();
-        tx();
-
-        writeBit(value & (1 << 0));
-        writeBit(value & (1 << 1));
-        writeBit(value & (1 << 2));
-        writeBit(value & (1 << 3));
-        writeBit(value & (1 << 4));
-        writeBit(value & (1 << 5));
-        writeBit(value & (1 << 6));
-        writeBit(value & (1 << 7));
-    }
-
-    template<typename...A>
-    inline static void oneWireWrite(auto value, A...args)
-    {
-        oneWireWrite(value);
-        oneWireWrite(args...);
-    }
-
-    static uint8_t oneWireRead()
-    {
-        constexpr auto readBit = [](auto pos) -> uint8_t {
-            InterruptGuard ig {};
-
-            pullUp();
-            tx();
-
-            pullDown();
-            _delay_us(2);
-
-            rx();
-            _delay_us(5);
-        
-            uint8_t bit = 0;
-
-            for (auto i { 0u }; i < 5; ++i) {
-                if (pin())
-                    bit = 1;
-                _delay_us(1);
-            }
-
-            _delay_us(45);
-
-            return bit << pos;
-        };
-
-        uint8_t byte = readBit(0) | readBit(1) | readBit(2) | readBit(3) | readBit(4) | readBit(5) | readBit(6) | readBit(7);
-        return byte;
-    }
-
-    static uint8_t calculateCRC(uint8_t* data, uint8_t length)
-    {
-        uint8_t crc = 0;
-
-        for (auto i = 0u; i < length; ++i) {
-            auto byte { data[i] };
-
-            for (auto j = 0u; j < 8; ++j) {
-                auto mix { ( crc ^ byte ) & 1 };
-                crc >>= 1;
-
-                if (mix)
-                    crc ^= 0x8C;
-
-                byte >>= 1;
-            }
-        }
-
-        return crc;
-    }
-
-    static constexpr auto pinMask() { return 1 << DS_PIN_NUM; }
-
-    inline static void pullUp() { DS_PORT |= pinMask(); }
-    inline static void pullDown() { DS_PORT &= ~pinMask(); }
-    inline static void tx() { DS_DDR |= pinMask(); }
-    inline static void rx() { DS_DDR &= ~pinMask(); }
-    inline static bool pin() { return DS_PIN & pinMask(); }
-};
+/*
+ * Copyright (C) 2021 adrian_007, adrian-007 on o2 point pl
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#pragma once
+
+#include <util/delay.h>
+
+#include "Pin.h"
+#include "InterruptGuard.h"
+#include "TimerWheel.h"
+#include "Serial.h"
+#include "Trace.h"
+
+class DS18B20
+{
+    using DataPin = io::Pin<io::PortD, 3>;
+
+public:
+    static void init()
+    {
+        if (oneWireInit()) {
+            configure();
+        }
+        else {
+            LOG(DS18B20, WARNING, " Sensor not present");
+        }
+
+        // Start the first conversion right away, it runs in background while the rest of the board boots.
+        poll();
+    }
+
+    /**
+     * Timer callback, alternates between starting a conversion and reading its result.
+     */
+    static void poll()
+    {
+        if (!converting()) {
+            converting() = startConversion();
+            
+            if (!converting()) {
+                setLastTemperatureValue(90 * 16);
+                TimerWheel::start(timer(), samplePeriod());
+            }
+            else {
+                TimerWheel::start(timer(), readDelay());
+            }
+        }
+        else {
+            converting() = false;
+
+            setLastTemperatureValue(readTemp());
+            TimerWheel::start(timer(), samplePeriod() - readDelay());
+        }
+    }
+
+    /**
+     * Worst case conversion time for 9-bit resolution, in milliseconds
+     */
+    static constexpr uint16_t conversionDuration() { return 94; }
+
+    /**
+     * Counted from the start of the conversion. A timer started within a millisecond fires up to 1 ms early, and
+     * the first conversion starts before the clock runs (its pending tick is serviced right at sei()).
+     */
+    static constexpr uint16_t readDelay() { return conversionDuration() + 1; }
+    static constexpr uint16_t samplePeriod() { return 60000U / samplesPerMinute(); }
+
+    /**
+     * 1-Wire timing in microseconds. Only the windows with an upper time limit run with interrupts disabled:
+     * presence sampling, the low time of a written bit and the sampling of a read bit.
+     */
+    static constexpr uint16_t resetLowTime() { return 500; }
+    static constexpr uint8_t presenceSampleDelay() { return 70; }
+    static constexpr uint16_t presenceRestTime() { return 430; }
+    static constexpr uint8_t writeOneLowTime() { return 8; }
+    static constexpr uint8_t writeZeroLowTime() { return 80; }
+    static constexpr uint8_t writeSlotTime() { return 88; }
+    static constexpr uint8_t readLowTime() { return 2; }
+    static constexpr uint8_t readSampleDelay() { return 5; }
+    static constexpr uint8_t readSampleTime() { return 5; }
+    static constexpr uint8_t readRecoveryTime() { return 45; }
+
+    /**
+     * Longest time the main loop keeps interrupts disabled, ADC_vect latency is bounded by it (see main.cpp)
+     */
+    static constexpr uint8_t longestAtomicWindow()
+    {
+        return max(max(presenceSampleDelay(), writeZeroLowTime()), max(writeOneLowTime(),
+            uint8_t(readLowTime() + readSampleDelay() + readSampleTime())));
+    }
+
+    static volatile int8_t& lastTemperatureValue()
+    {
+        static volatile int8_t lastTemp = 90;
+        return lastTemp;
+    }
+
+    /**
+     * Last reading in 1/16 of degree, error values are scaled the same way (90 * 16, 127 * 16)
+     */
+    static volatile int16_t& lastRawTemperatureValue()
+    {
+        static volatile int16_t lastRawTemp = 90 * 16;
+        return lastRawTemp;
+    }
+
+    /**
+     * Incremented with every new reading (or failed attempt), lets consumers tell a new sample from a repeated one
+     */
+    static volatile uint8_t& sampleCount()
+    {
+        static volatile uint8_t count = 0;
+        return count;
+    }
+
+private:
+    enum Commands : uint8_t
+    {
+        SkipROM            = 0xCC,
+        StartConversion    = 0x44,
+        ReadScratchPad     = 0xBE,
+        WriteScratchPad    = 0x4E,
+        CommitScratchPad   = 0x48
+    };
+
+    static constexpr uint8_t samplesPerMinute() { return 12; }
+
+    static constexpr uint8_t max(uint8_t a, uint8_t b) { return a > b ? a : b; }
+
+    static void configure()
+    {
+        uint8_t sp[9] { 0 };
+        bool changeResolution { true };
+
+        if (readScratchPad(sp)) {
+            auto resolution { sp[4] >> 5 };
+            
+            switch (resolution) {
+                case 0:
+                    LOG(DS18B20, INFO, " Sensor present, resolution: ", 9, FLASH_STRING("-bits"));
+                    changeResolution = false;
+                    break;
+                case 1:
+                    LOG(DS18B20, INFO, " Sensor present, resolution: ", 10, FLASH_STRING("-bits"));
+                    break;
+                case 2:
+                    LOG(DS18B20, INFO, " Sensor present, resolution: ", 11, FLASH_STRING("-bits"));
+                    break;
+                case 3:
+                    LOG(DS18B20, INFO, " Sensor present, resolution: ", 12, FLASH_STRING("-bits"));
+                    break;
+                default:
+                    LOG(DS18B20, WARNING, " Sensor present, unknown resolution - read value: ", resolution);
+                    break;
+            }
+            
+        }
+        else {
+            LOG(DS18B20, WARNING, " Sensor not present, cannot read scratchpad");
+        }
+
+        // EEPROM commit blocks for 15 ms, so do it only if the sensor was not configured yet
+        if (changeResolution) {
+            // 9-bit resolution
+            writeScratchPad(0xFF, 0xFF, 0x00);
+            commitScratchPad();    
+        }
+    }
+
+    static volatile bool& converting()
+    {
+        static volatile bool converting { false };
+        return converting;
+    }
+
+    static Timer& timer()
+    {
+        static Timer timer { poll };
+        return timer;
+    }
+
+    static void setLastTemperatureValue(int16_t rawTemp)
+    {
+        lastRawTemperatureValue() = rawTemp;
+        lastTemperatureValue() = (int8_t)(rawTemp / 16);
+        TRACE(TemperatureRead, uint8_t(rawTemp / 16));
+        ++sampleCount();
+    }
+
+    static int16_t readTemp()
+    {
+        uint8_t sp[9] { 0 };
+        if (!readScratchPad(sp))
+            return 127 * 16;
+
+        return (int16_t)(sp[1] << 8) + sp[0];
+    }
+
+    static bool startConversion()
+    {
+        if (!oneWireInit()) {
+            LOG(DS18B20, ERROR, "Could not initialize 1-Wire reset pulse prior to starting conversion");
+            return false;
+        }
+
+        oneWireWrite(Commands::SkipROM, Commands::StartConversion);
+        oneWireStrongPullup();
+        return true;
+    }
+
+    static bool readScratchPad(uint8_t scratchPad[9])
+    {
+        if (!oneWireInit()) {
+            LOG(DS18B20, ERROR, "Could not initialize 1-Wire reset pulse prior to reading scratch pad data");
+            return false;
+        }
+
+        oneWireWrite(Commands::SkipROM, Commands::ReadScratchPad);
+
+        scratchPad[0] = oneWireRead();
+        scratchPad[1] = oneWireRead();
+        scratchPad[2] = oneWireRead();
+        scratchPad[3] = oneWireRead();
+        scratchPad[4] = oneWireRead();
+        scratchPad[5] = oneWireRead();
+        scratchPad[6] = oneWireRead();
+        scratchPad[7] = oneWireRead();
+        scratchPad[8] = oneWireRead();
+
+        return calculateCRC(&scratchPad[0], 8) == scratchPad[8];
+    }
+
+    static bool writeScratchPad(uint8_t th, uint8_t tl, uint8_t config)
+    {
+        if (!oneWireInit()) {
+            LOG(DS18B20, ERROR, "Could not initialize 1-Wire reset pulse prior to writing scratch pad data");
+            return false;
+        }
+
+        oneWireWrite(Commands::SkipROM, Commands::WriteScratchPad, th, tl, config);
+        return true;
+    }
+
+    static bool commitScratchPad()
+    {
+        if (!oneWireInit()) {
+            LOG(DS18B20, ERROR, "Could not initialize 1-Wire reset pulse prior to commiting scratch pad data to EEPROM");
+            return false;
+        }
+
+        oneWireWrite(Commands::SkipROM, Commands::CommitScratchPad);
+        oneWireStrongPullup();
+        _delay_ms(15);
+        return true;
+    }
+
+    inline static void oneWireStrongPullup()
+    {
+        pullUp();
+        tx();
+    }
+
+    /**
+     * Only the windows with an upper time limit are atomic (at most longestAtomicWindow()), the rest of 1-Wire
+     * timing are minimums which interrupts may stretch - so ADC_vect and the clock keep running during a transfer.
+     */
+    static bool oneWireInit()
+    {
+        pullUp();
+        tx();
+        pullDown();
+
+        _delay_us(resetLowTime()); // 480 us + 20 us of margin
+
+        bool presence;
+        {
+            InterruptGuard ig {};
+
+            rx();
+            // Presence pulse starts 15 - 60 us after the release and lasts 60 - 240 us
+            _delay_us(presenceSampleDelay());
+            presence = !pin();
+        }
+
+        // Rest of the presence window
+        _delay_us(presenceRestTime());
+
+        pullUp();
+        tx();
+
+        return presence;
+    }
+    
+    static void oneWireWrite(auto value)
+    {
+        static_assert(sizeof(value) == 1, "You may write at most one byte at a time");
+
+        constexpr auto writeBit = [](bool bit) {
+            {
+                // Low time is the bit: 1 - 15 us for 1, 60 - 120 us for 0
+                InterruptGuard ig {};
+
+                pullDown();
+                bit ? _delay_us(writeOneLowTime()) : _delay_us(writeZeroLowTime());
+                pullUp();
+            }
+
+            bit ? _delay_us(writeSlotTime() - writeOneLowTime()) : _delay_us(writeSlotTime() - writeZeroLowTime());
+        };
+
+        pullUp();
+        tx();
+
+        writeBit(value & (1 << 0));
+        writeBit(value & (1 << 1));
+        writeBit(value & (1 << 2));
+        writeBit(value & (1 << 3));
+        writeBit(value & (1 << 4));
+        writeBit(value & (1 << 5));
+        writeBit(value & (1 << 6));
+        writeBit(value & (1 << 7));
+    }
+
+    template<typename...A>
+    inline static void oneWireWrite(auto value, A...args)
+    {
+        oneWireWrite(value);
+        oneWireWrite(args...);
+    }
+
+    static uint8_t oneWireRead()
+    {
+        constexpr auto readBit = [](auto pos) -> uint8_t {
+            uint8_t bit = 0;
+            {
+                // Sensor's bit is valid only within 15 us of the falling edge
+                InterruptGuard ig {};
+
+                pullUp();
+                tx();
+
+                pullDown();
+                _delay_us(readLowTime());
+
+                rx();
+                _delay_us(readSampleDelay());
+
+                for (auto i { 0u }; i < readSampleTime(); ++i) {
+                    if (pin())
+                        bit = 1;
+                    _delay_us(1);
+                }
+            }
+
+            _delay_us(readRecoveryTime());
+
+            return bit << pos;
+        };
+
+        uint8_t byte = readBit(0) | readBit(1) | readBit(2) | readBit(3) | readBit(4) | readBit(5) | readBit(6) | readBit(7);
+        return byte;
+    }
+
+    static uint8_t calculateCRC(uint8_t* data, uint8_t length)
+    {
+        uint8_t crc = 0;
+
+        for (auto i = 0u; i < length; ++i) {
+            auto byte { data[i] };
+
+            for (auto j = 0u; j < 8; ++j) {
+                auto mix { ( crc ^ byte ) & 1 };
+                crc >>= 1;
+
+                if (mix)
+                    crc ^= 0x8C;
+
+                byte >>= 1;
+            }
+        }
+
+        return crc;
+    }
+
+    inline static void pullUp() { DataPin::high(); }
+    inline static void pullDown() { DataPin::low(); }
+    inline static void tx() { DataPin::output(); }
+    inline static void rx() { DataPin::input(); }
+    inline static bool pin() { return DataPin::read(); }
+};
@@ -1,47 +1,93 @@
-/*
- * Copyright (C) 2021 adrian_007, adrian-007 on o2 point pl
- *
- * This program is free software; you can redistribute it and/or modify
- * it under the terms of the GNU General Public License as published by
- * the Free Software Foundation; either version 3 of the License, or
- * (at your option) any later version.
- *
- * This program is distributed in the hope that it will be useful,
- * but WITHOUT ANY WARRANTY; without even the implied warranty of
- * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
- * GNU General Public License for more details.
- *
- * You should have received a copy of the GNU General Public License
- * along with this program; if not, write to the Free Software
- * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
- */
-
-#pragma once
-
-#include <avr/pgmspace.h>
-
-template<typename T>
-inline T pgm_read(const T* ptr)
-{
-    switch (sizeof(T)) {
-        case 1: return pgm_read_byte(ptr);
-        case 2: return pgm_read_word(ptr);
-        case 4: return pgm_read_dword(ptr);
-        default: {
-            T result;
-            memcpy_P(&result, ptr, sizeof(T));
-            return result;
-        }
-    }
-}
-
-template<typename T>
-struct flash
-{
-    const T value;
-
-    inline T get() const { return pgm_read(&value); }
-
-    template<typename R = T>
-    inline operator R() const { return pgm_read(&value); }
-};
+/*
+ * Copyright (C) 2021 adrian_007, adrian-007 on o2 point pl
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#pragma once
+
+#include <avr/pgmspace.h>
+#include <stdint.h>
+#include <string.h>
+
+namespace detail
+{
+    // Scalars are read with a single LPM sequence, raw value is copied so that any trivially copyable T works
+    template<unsigned Size>
+    struct PgmReader
+    {
+        template<typename T>
+        static inline void read(const T* ptr, T& result) { memcpy_P(&result, ptr, sizeof(T)); }
+    };
+
+    template<>
+    struct PgmReader<1>
+    {
+        template<typename T>
+        static inline void read(const T* ptr, T& result) { uint8_t raw = pgm_read_byte(ptr); memcpy(&result, &raw, 1); }
+    };
+
+    template<>
+    struct PgmReader<2>
+    {
+        template<typename T>
+        static inline void read(const T* ptr, T& result) { uint16_t raw = pgm_read_word(ptr); memcpy(&result, &raw, 2); }
+    };
+
+    template<>
+    struct PgmReader<4>
+    {
+        template<typename T>
+        static inline void read(const T* ptr, T& result) { uint32_t raw = pgm_read_dword(ptr); memcpy(&result, &raw, 4); }
+    };
+}
+
+template<typename T>
+inline T pgm_read(const T* ptr)
+{
+    T result;
+    detail::PgmReader<sizeof(T)>::read(ptr, result);
+    return result;
+}
+
+/**
+ * Reads a byte and advances the address with a single LPM Z+, for streaming flash ranges
+ */
+inline uint8_t pgm_read_byte_postinc(const uint8_t*& address)
+{
+#ifdef __AVR__
+    uint8_t result;
+    asm volatile("lpm %0, Z+" : "=r" (result), "+z" (address));
+    return result;
+#else
+    return pgm_read_byte(address++);
+#endif
+}
+
+template<typename T>
+struct flash
+{
+    const T value;
+
+    inline T get() const { return pgm_read(&value); }
+
+    template<typename R = T>
+    inline operator R() const { return pgm_read(&value); }
+};
+
+/**
+ * String literal placed in program memory, printed by Serial::print(const flash<char>*)
+ */
+#define FLASH_STRING(s) (reinterpret_cast<const flash<char>*>(PSTR(s)))
@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2021 adrian_007, adrian-007 on o2 point pl
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+
+#pragma once
+
+#include <stdint.h>
+
+#ifndef HOST_BUILD
+# include <avr/io.h>
+#endif
+
+/**
+ * Compile time GPIO. Ports are types and pins are types, every operation is an inline function on a constant
+ * I/O address, so avr-gcc emits single sbi / cbi / sbic / sbis instructions, same as hand written register code.
+ *
+ * With HOST_BUILD defined ports are backed by plain memory instead of registers, drivers compile on a PC and
+ * tests can inspect or preset pin state through Port::out(), ddr() and in().
+ */
+namespace io
+{
+#ifndef HOST_BUILD
+#   define IO_DEFINE_PORT(Letter) \
+    struct Port##Letter \
+    { \
+        static volatile uint8_t& in() { return PIN##Letter; } \
+        static volatile uint8_t& ddr() { return DDR##Letter; } \
+        static volatile uint8_t& out() { return PORT##Letter; } \
+    };
+#else
+#   define IO_DEFINE_PORT(Letter) \
+    struct Port##Letter \
+    { \
+        static volatile uint8_t& in() { static volatile uint8_t in { 0 }; return in; } \
+        static volatile uint8_t& ddr() { static volatile uint8_t ddr { 0 }; return ddr; } \
+        static volatile uint8_t& out() { static volatile uint8_t out { 0 }; return out; } \
+    };
+#endif
+
+    IO_DEFINE_PORT(B)
+    IO_DEFINE_PORT(C)
+    IO_DEFINE_PORT(D)
+
+#undef IO_DEFINE_PORT
+
+    template<typename Port, uint8_t Bit>
+    struct Pin
+    {
+        static_assert(Bit < 8, "Port has 8 pins");
+
+        Pin() = delete;
+
+        static constexpr uint8_t mask() { return 1 << Bit; }
+
+        static inline void high() { Port::out() |= mask(); }
+        static inline void low() { Port::out() &= ~mask(); }
+        static inline void set(bool value) { value ? high() : low(); }
+
+        static inline void output() { Port::ddr() |= mask(); }
+        static inline void input() { Port::ddr() &= ~mask(); }
+
+        static inline bool read() { return Port::in() & mask(); }
+    };
+}
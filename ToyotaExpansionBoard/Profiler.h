@@ -0,0 +1,207 @@
+/*
+ * Copyright (C) 2021 adrian_007, adrian-007 on o2 point pl
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+
+#pragma once
+
+#if defined(ENABLE_PROFILER) && defined(ENABLE_ADC_TRACE)
+# error "ADC trace uses UART exclusively, disable ENABLE_PROFILER"
+#endif
+
+#ifdef ENABLE_PROFILER
+
+#include <avr/io.h>
+#include <stdint.h>
+
+#include "Board.h"
+#include "Serial.h"
+#include "TimerWheel.h"
+
+#ifndef PROFILER_BUCKET_SHIFT
+# define PROFILER_BUCKET_SHIFT 7
+#endif
+
+// Defined (not only declared) in this header, which relies on main.cpp being the only translation unit.
+extern "C" {
+    // Interrupted program counter (word address), stored by Profiler::capture() for __vector_profiler_sample()
+    volatile uint16_t profilerPC __attribute__((used));
+
+    // Reached from TIMER0_COMPA_vect, not from the vector table. The __vector prefix keeps avr-gcc from
+    // reporting a misspelled signal handler (-Wmisspelled-isr).
+    void __vector_profiler_sample() __attribute__((signal, used));
+}
+
+/**
+ * Statistical profiler (ENABLE_PROFILER), resolved to functions on the host by tools/profile.py.
+ *
+ * Timer0 interrupts the program at ~1 kHz (samplingFrequency() rounded to whole timer counts), a rate that is
+ * not a multiple of the 1 ms clock so samples do not lock to its ISR. The naked TIMER0_COMPA_vect stub copies
+ * the return address from the stack before anything else is pushed, the sample is then counted in a histogram
+ * of 2^PROFILER_BUCKET_SHIFT byte buckets of flash.
+ *
+ * Interrupts do not nest, so a sample due while another ISR or an InterruptGuard section runs is only taken
+ * after it ends. Such samples are recognized by their latency and counted as "blocked" instead of being
+ * attributed to an innocent main loop instruction.
+ *
+ * Every dumpPeriod() the histogram is printed and cleared (sampling is paused meanwhile):
+ *   PH <bucket shift> <samples> <blocked>
+ *   P <bucket> <count>                       - non-zero buckets only, all hex
+ */
+class Profiler
+{
+public:
+    Profiler() = delete;
+
+    static constexpr uint8_t bucketShift() { return PROFILER_BUCKET_SHIFT; }
+    static constexpr uint16_t bucketCount() { return (FLASHEND + 1UL) >> bucketShift(); }
+    static constexpr uint16_t samplingFrequency() { return 1024; }
+    static constexpr uint8_t clockSelect() { return Board::timerClockSelect(samplingFrequency(), UINT8_MAX + 1U); }
+    static constexpr uint16_t prescaler() { return Board::timerPrescaler(clockSelect()); }
+    static constexpr uint8_t compareValue() { return Board::timerCounts(clockSelect(), samplingFrequency()) - 1; }
+    static constexpr uint16_t dumpPeriod() { return 5000; }
+
+    /**
+     * Samples taken this many CPU cycles late were held off by another ISR or disabled interrupts
+     */
+    static constexpr uint16_t blockedCycles() { return 128; }
+
+    /**
+     * blockedCycles() in Timer0 counts, 2 counts of 64 cycles at 4 MHz
+     */
+    static constexpr uint8_t blockedLatency() { return (blockedCycles() + prescaler() - 1) / prescaler(); }
+
+    static void init()
+    {
+        static_assert(Board::timerCounts(clockSelect(), samplingFrequency()) <= UINT8_MAX + 1U, "F_CPU too high for the sampling frequency");
+        static_assert(compareValue() > blockedLatency(), "F_CPU too low for the sampling frequency");
+
+        // CTC mode
+        TCCR0A = (1 << WGM01);
+        TCCR0B = (clockSelect() << CS00);
+        OCR0A = compareValue();
+        TIMSK0 |= (1 << OCIE0A);
+
+        static Timer dumpTimer { dump };
+        TimerWheel::start(dumpTimer, dumpPeriod(), dumpPeriod());
+    }
+
+    /**
+     * Body of the naked TIMER0_COMPA_vect. Flags are untouched and every register used is restored before
+     * jumping to __vector_profiler_sample(), a regular interrupt handler which returns with reti.
+     */
+    __attribute__((always_inline)) static inline void capture()
+    {
+        asm volatile(
+            "push r30"                      "\n\t"
+            "push r31"                      "\n\t"
+            "in r30, __SP_L__"              "\n\t"
+            "in r31, __SP_H__"              "\n\t"
+            "push r24"                      "\n\t"
+            // Return address is above r30 and r31, high byte first
+            "ldd r24, Z+3"                  "\n\t"
+            "sts profilerPC+1, r24"         "\n\t"
+            "ldd r24, Z+4"                  "\n\t"
+            "sts profilerPC, r24"           "\n\t"
+            "pop r24"                       "\n\t"
+            "pop r31"                       "\n\t"
+            "pop r30"                       "\n\t"
+            "rjmp __vector_profiler_sample" "\n\t"
+        );
+    }
+
+    static void sample(uint16_t pc, uint8_t latency)
+    {
+        if (total() < UINT16_MAX)
+            ++total();
+
+        if (latency >= blockedLatency()) {
+            if (blocked() < UINT16_MAX)
+                ++blocked();
+            return;
+        }
+
+        auto& count { histogram()[uint16_t(pc << 1) >> bucketShift()] };
+        if (count < UINT16_MAX)
+            ++count;
+    }
+
+    /**
+     * Timer callback, prints and clears the histogram
+     */
+    static void dump()
+    {
+        TIMSK0 &= ~(1 << OCIE0A);
+
+        Serial::print(FLASH_STRING("PH "));
+        Serial::print(bucketShift(), Serial::Base::Hex);
+        Serial::print(' ');
+        Serial::print(total(), Serial::Base::Hex);
+        Serial::print(' ');
+        Serial::print(blocked(), Serial::Base::Hex);
+        Serial::println();
+
+        for (auto bucket { 0u }; bucket < bucketCount(); ++bucket) {
+            auto& count { histogram()[bucket] };
+            if (!count)
+                continue;
+
+            Serial::print(FLASH_STRING("P "));
+            Serial::print(uint16_t(bucket), Serial::Base::Hex);
+            Serial::print(' ');
+            Serial::print(count, Serial::Base::Hex);
+            Serial::println();
+
+            count = 0;
+        }
+
+        total() = 0;
+        blocked() = 0;
+
+        // Restart the period so the dump itself is not sampled late
+        TCNT0 = 0;
+        TIFR0 = (1 << OCF0A);
+        TIMSK0 |= (1 << OCIE0A);
+    }
+
+private:
+    static uint16_t* histogram()
+    {
+        static uint16_t histogram[bucketCount()] { 0 };
+        return histogram;
+    }
+
+    static uint16_t& total()
+    {
+        static uint16_t total { 0 };
+        return total;
+    }
+
+    static uint16_t& blocked()
+    {
+        static uint16_t blocked { 0 };
+        return blocked;
+    }
+};
+
+// Only translation unit is main.cpp, see above
+void __vector_profiler_sample()
+{
+    Profiler::sample(profilerPC, TCNT0);
+}
+
+#endif
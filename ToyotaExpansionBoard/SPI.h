@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2021 adrian_007, adrian-007 on o2 point pl
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+
+#pragma once
+
+#include <stdint.h>
+
+#include "Pin.h"
+
+/**
+ * SPI master on the hardware SPI unit, mode 0, MSB first. HOST_BUILD replaces the unit with transferHandler(),
+ * which sees every byte sent and provides the byte received.
+ */
+class SPI
+{
+public:
+    using Sck = io::Pin<io::PortB, 5>;
+    using Miso = io::Pin<io::PortB, 4>;
+    using Mosi = io::Pin<io::PortB, 3>;
+    using Ss = io::Pin<io::PortB, 2>;
+
+    SPI() = delete;
+
+    static void init()
+    {
+        // SS has to be an output, otherwise pulling it low switches the unit to slave mode
+        Ss::output();
+        Mosi::output();
+        Sck::output();
+
+#ifndef HOST_BUILD
+        // Enable SPI, master, set clock rate fck/16
+        SPCR = (1 << SPE) | (1 << MSTR) | (1 << SPR0);
+#endif
+    }
+
+    static uint8_t transfer(uint8_t data)
+    {
+#ifndef HOST_BUILD
+        SPDR = data;
+        while (!(SPSR & (1 << SPIF)));
+        return SPDR;
+#else
+        return transferHandler() ? transferHandler()(data) : 0xFF;
+#endif
+    }
+
+#ifdef HOST_BUILD
+    using TransferHandler = uint8_t (*)(uint8_t);
+
+    static TransferHandler& transferHandler()
+    {
+        static TransferHandler handler { nullptr };
+        return handler;
+    }
+#endif
+};
@@ -1,217 +1,703 @@
-/*
- * Copyright (C) 2021 adrian_007, adrian-007 on o2 point pl
- *
- * This program is free software; you can redistribute it and/or modify
- * it under the terms of the GNU General Public License as published by
- * the Free Software Foundation; either version 3 of the License, or
- * (at your option) any later version.
- *
- * This program is distributed in the hope that it will be useful,
- * but WITHOUT ANY WARRANTY; without even the implied warranty of
- * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
- * GNU General Public License for more details.
- *
- * You should have received a copy of the GNU General Public License
- * along with this program; if not, write to the Free Software
- * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
- */
-
-#pragma once
-
-#include "TWI.h"
-#include "ThermometerFont.h"
-
-#include <util/delay.h>
-
-#define RESET_PIN  PIND0
-#define RESET_PORT PORTD
-#define RESET_DDR  DDRD
-
-class SSD1306
-{
-    struct Commands
-    {
-        static constexpr uint8_t CommandTag                  { 0x00 };
-        static constexpr uint8_t DataTag                     { 0x40 };
-
-        static constexpr uint8_t DisplayOff                  { 0xAE };
-        static constexpr uint8_t SetDisplayClockDiv          { 0xD5 };
-        static constexpr uint8_t SetMultiplex                { 0xA8 };
-        static constexpr uint8_t SetDisplayOffset            { 0xD3 };
-        static constexpr uint8_t SetStartLine                { 0x40 };
-        static constexpr uint8_t ChargePump                  { 0x8D };
-        static constexpr uint8_t MemoryMode                  { 0x20 };
-        static constexpr uint8_t SegRemap                    { 0xA0 };
-        static constexpr uint8_t COMOutputScanDirNormal      { 0xC0 };
-        static constexpr uint8_t COMPinsHWConfig             { 0xDA };
-        static constexpr uint8_t SetContrast                 { 0x81 };
-        static constexpr uint8_t SetPrecharge                { 0xD9 };
-        static constexpr uint8_t SetVComDetect               { 0xDB };
-        static constexpr uint8_t DisplayAllOnResume          { 0xA4 };
-        static constexpr uint8_t NormalDisplay               { 0xA6 };
-        static constexpr uint8_t InvertDisplay               { 0xA7 };
-        static constexpr uint8_t DisplayOn                   { 0xAF };
-        static constexpr uint8_t SetPageStartAddress         { 0xB0 };
-        static constexpr uint8_t SetColumnLSB                { 0x00 };
-        static constexpr uint8_t SetColumnMSB                { 0x10 };
-        static constexpr uint8_t DeactivateScroll            { 0x2E };
-        static constexpr uint8_t SetColumnAddress            { 0x21 };
-        static constexpr uint8_t SetPageAddress              { 0x22 };
-
-        struct MemoryMode
-        {
-            static constexpr uint8_t Horizontal { 0x00 };
-            static constexpr uint8_t Vertical { 0x01 };
-            static constexpr uint8_t Page { 0x02 };
-        };
-    };
-
-    static constexpr uint8_t _displayHeight { 64 };
-    static constexpr uint8_t _displayWidth { 128 };
-    static constexpr uint8_t _pageCount { _displayHeight / 8 };
-    static constexpr uint8_t _address { 0x3C };
-
-public:
-    static void init()
-    {
-        // Set up RESET pin as output
-        RESET_DDR &= ~(1 << RESET_PIN);
-
-        // Pull it down and keep for 10 us
-        RESET_PORT &= ~(1 << RESET_PIN);
-        _delay_us(10);
-        
-        // Pull high to enable the display
-        RESET_PORT |= (1 << RESET_PIN);
-
-        sendCommand(
-            Commands::DisplayOff,
-            Commands::SetMultiplex, 0x3F,
-            Commands::SetDisplayOffset, 0x00,
-            Commands::SetStartLine,
-            Commands::SegRemap,
-            Commands::SetDisplayClockDiv, 0x80,
-            Commands::COMOutputScanDirNormal,
-            Commands::COMPinsHWConfig, 0x12,
-            Commands::SetContrast, 0x80,
-            Commands::DisplayAllOnResume,
-            Commands::NormalDisplay,
-            Commands::ChargePump, 0x14,
-            Commands::SetPrecharge, 0xF1,
-            Commands::MemoryMode, Commands::MemoryMode::Vertical,
-            Commands::SetVComDetect, 0x20,
-            Commands::DeactivateScroll
-        );
-
-        clearDisplay();
-
-        sendCommand(Commands::DisplayOn);
-
-        drawTemp(127);
-    }
-
-    static void clearDisplay() {
-        setDrawRect(0, _displayWidth - 1, 0, _pageCount - 1);
-
-        ScopedTWI twi { _address };
-        twi.write(Commands::DataTag);
-
-        for (auto w { 0u }; w < _displayWidth / 32; ++w) {
-            for (auto h { 0u }; h < _displayHeight; ++h) {
-                twi.write(0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
-            }
-        }
-    }
-
-    static void drawTemp(int8_t temp)
-    {
-        bool negative { temp < 0 };
-        if (negative)
-            temp *= -1;
-
-        int8_t chars[5] = { '-', '-', '-', '-', '-' };
-        static int8_t prevChars[sizeof(chars)] { 0 };
-    
-        if (temp < 70) {
-            int8_t tempDigits[2] { int8_t(temp / 10), int8_t(temp % 10) };
-
-            int pos = sizeof(chars);
-            chars[--pos] = 'C';
-            chars[--pos] = '*';
-
-            chars[--pos] = '0' + tempDigits[1];
-
-            if (tempDigits[0] > 0)
-                chars[--pos] = '0' + tempDigits[0];
-
-            if (negative)
-                chars[--pos] = '-';
-            
-            while (pos > 0)
-                chars[--pos] = ' ';
-
-            bool redraw { false };
-            for (auto i { 0u }; i < sizeof(chars); ++i) {
-                if (prevChars[i] != chars[i]) {
-                    redraw = true;
-                    break;
-                }
-            }
-
-            if (!redraw) {
-                return;
-            }
-        }
-
-        const uint8_t pageOffset { 1u };
-        uint8_t columnOffset { 0u };
-
-        for (auto i = 0u; i < sizeof(chars); ++i) {
-            if (chars[i] != prevChars[i]) {
-                drawChar<ThermometerFont::Handler>(chars[i], pageOffset, columnOffset);
-                prevChars[i] = chars[i];
-            } 
-
-            columnOffset += ThermometerFont::Handler::width(chars[i]);
-        }
-    }
-
-private:
-    template<typename FontHandler, typename SymbolType>
-    static void drawChar(SymbolType symbol, uint8_t pageStart = 0u, uint8_t offset = 0u)
-    {
-        auto* charData = FontHandler::dataForSymbol(symbol);
-        
-        if (charData == nullptr)
-            return;
-        
-        const auto pages { FontHandler::height() / 8 };
-        const auto width { FontHandler::width() };
-
-        setDrawRect(offset, offset + width, pageStart, pageStart + pages - 1);
-
-        ScopedTWI twi { _address };
-        twi.write(Commands::DataTag);
-
-        for (auto p { 0u }; p < pages; ++p) {
-            for (auto w { 0u }; w < width; ++w) {
-                twi.write((++charData)->get());
-            }
-        }
-    }
-
-    static void setDrawRect(uint8_t columnBegin, uint8_t columnEnd, uint8_t pageBegin, uint8_t pageEnd)
-    {
-        sendCommand(
-            Commands::SetColumnAddress, columnBegin, columnEnd,
-            Commands::SetPageAddress, pageBegin, pageEnd
-        );
-    }
-
-    template<typename...Args>
-    inline static void sendCommand(Args...commands)
-    {
-        ScopedTWI twi { _address };
-        twi.write(Commands::CommandTag, commands...);
-    }
-};
+/*
+ * Copyright (C) 2021 adrian_007, adrian-007 on o2 point pl
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#pragma once
+
+#include "TWI.h"
+#include "Clock.h"
+#include "Trace.h"
+#include "ThermometerFont.h"
+
+#include <util/delay.h>
+#include <string.h>
+
+#include "Pin.h"
+
+#if defined(ENABLE_SSD1306_FRAMEBUFFER) && !defined(HOST_BUILD) && RAMEND < 0x8FF
+# error "Framebuffer needs 2 KB of RAM (ATmega328P)"
+#endif
+
+/**
+ * SSD1306 128x64 OLED over TWI, in vertical addressing mode.
+ *
+ * By default everything is drawn straight to the display. With ENABLE_SSD1306_FRAMEBUFFER (MCUs with 2 KB of RAM)
+ * drawing goes to a RAM copy of the display instead and only the bytes that changed are sent afterwards,
+ * see FrameBuffer.
+ */
+class SSD1306
+{
+    using ResetPin = io::Pin<io::PortD, 0>;
+
+    struct Commands
+    {
+        static constexpr uint8_t CommandTag                  { 0x00 };
+        static constexpr uint8_t DataTag                     { 0x40 };
+
+        static constexpr uint8_t DisplayOff                  { 0xAE };
+        static constexpr uint8_t SetDisplayClockDiv          { 0xD5 };
+        static constexpr uint8_t SetMultiplex                { 0xA8 };
+        static constexpr uint8_t SetDisplayOffset            { 0xD3 };
+        static constexpr uint8_t SetStartLine                { 0x40 };
+        static constexpr uint8_t ChargePump                  { 0x8D };
+        static constexpr uint8_t MemoryMode                  { 0x20 };
+        static constexpr uint8_t SegRemap                    { 0xA0 };
+        static constexpr uint8_t COMOutputScanDirNormal      { 0xC0 };
+        static constexpr uint8_t COMPinsHWConfig             { 0xDA };
+        static constexpr uint8_t SetContrast                 { 0x81 };
+        static constexpr uint8_t SetPrecharge                { 0xD9 };
+        static constexpr uint8_t SetVComDetect               { 0xDB };
+        static constexpr uint8_t DisplayAllOnResume          { 0xA4 };
+        static constexpr uint8_t NormalDisplay               { 0xA6 };
+        static constexpr uint8_t InvertDisplay               { 0xA7 };
+        static constexpr uint8_t DisplayOn                   { 0xAF };
+        static constexpr uint8_t SetPageStartAddress         { 0xB0 };
+        static constexpr uint8_t SetColumnLSB                { 0x00 };
+        static constexpr uint8_t SetColumnMSB                { 0x10 };
+        static constexpr uint8_t DeactivateScroll            { 0x2E };
+        static constexpr uint8_t SetColumnAddress            { 0x21 };
+        static constexpr uint8_t SetPageAddress              { 0x22 };
+
+        struct MemoryMode
+        {
+            static constexpr uint8_t Horizontal { 0x00 };
+            static constexpr uint8_t Vertical { 0x01 };
+            static constexpr uint8_t Page { 0x02 };
+        };
+    };
+
+    static constexpr uint8_t _displayHeight { 64 };
+    static constexpr uint8_t _displayWidth { 128 };
+    static constexpr uint8_t _pageCount { _displayHeight / 8 };
+    static constexpr uint8_t _address { 0x3C };
+
+public:
+    /**
+     * Shortest and longest delay before retrying a display that stopped responding, doubled on each failure
+     */
+    static constexpr uint16_t minRetryDelay() { return 250; }
+    static constexpr uint16_t maxRetryDelay() { return 8000; }
+
+    /**
+     * Stale content (the temperature saved before power down, shown until the sensor is read) is drawn dimmed
+     */
+    static constexpr uint8_t normalContrast() { return 0x80; }
+    static constexpr uint8_t staleContrast() { return 0x08; }
+
+    static bool init()
+    {
+        // Set up RESET pin as output
+        ResetPin::output();
+
+        // Pull it down and keep for 10 us
+        ResetPin::low();
+        _delay_us(10);
+        
+        // Pull high to enable the display
+        ResetPin::high();
+
+        {
+            static const flash<uint8_t> PROGMEM initSequence[] {
+                Commands::CommandTag,
+                Commands::DisplayOff,
+                Commands::SetMultiplex, 0x3F,
+                Commands::SetDisplayOffset, 0x00,
+                Commands::SetStartLine,
+                Commands::SegRemap,
+                Commands::SetDisplayClockDiv, 0x80,
+                Commands::COMOutputScanDirNormal,
+                Commands::COMPinsHWConfig, 0x12,
+                Commands::SetContrast, normalContrast(),
+                Commands::DisplayAllOnResume,
+                Commands::NormalDisplay,
+                Commands::ChargePump, 0x14,
+                Commands::SetPrecharge, 0xF1,
+                Commands::MemoryMode, Commands::MemoryMode::Vertical,
+                Commands::SetVComDetect, 0x20,
+                Commands::DeactivateScroll
+            };
+
+            ScopedTWI twi { _address };
+            twi.writeFlash(initSequence, sizeof(initSequence));
+        }
+
+        if (!TWI::ok() || !clearDisplay() || !sendCommand(Commands::DisplayOn)
+            || (stale() && !sendCommand(Commands::SetContrast, staleContrast()))) {
+            LOG(SSD1306, ERROR, "Display init failed, status: ", uint8_t(TWI::status()));
+            goOffline();
+            return false;
+        }
+
+        online() = true;
+        retryDelay() = minRetryDelay();
+        // Display RAM was cleared, everything has to be drawn again
+        ++generation();
+        return true;
+    }
+
+    /**
+     * Marks what is on the display as stale (dimmed) or fresh. Kept over reconnects, an offline display gets
+     * it during init().
+     */
+    static void setStale(bool value)
+    {
+        if (stale() == value)
+            return;
+
+        stale() = value;
+
+        if (online() && !sendCommand(Commands::SetContrast, value ? staleContrast() : normalContrast())) {
+            LOG(SSD1306, ERROR, "Display write failed, status: ", uint8_t(TWI::status()));
+            goOffline();
+        }
+    }
+
+    static bool clearDisplay() {
+        if (!setDrawRect(0, _displayWidth - 1, 0, _pageCount - 1))
+            return false;
+
+        {
+            ScopedTWI twi { _address };
+            twi.write(Commands::DataTag);
+            twi.fill(0x00, uint16_t(_displayWidth) * _pageCount);
+        }
+
+#ifdef ENABLE_SSD1306_FRAMEBUFFER
+        memset(&frameBuffer(), 0, sizeof(FrameBuffer));
+#endif
+
+        return TWI::ok();
+    }
+
+    /**
+     * Draws temperature, redrawing only changed characters. Returns false if the display did not respond,
+     * in which case the call is cheap until the retry delay passes and the display gets initialized again.
+     */
+    static bool drawTemp(int8_t temp)
+    {
+        if (!online() && !reconnect())
+            return false;
+
+        bool negative { temp < 0 };
+        if (negative)
+            temp *= -1;
+
+        int8_t chars[5] = { '-', '-', '-', '-', '-' };
+        static int8_t prevChars[sizeof(chars)] { 0 };
+        static uint8_t drawnGeneration { 0 };
+
+        if (drawnGeneration != generation()) {
+            drawnGeneration = generation();
+
+            for (auto& c : prevChars)
+                c = 0;
+        }
+    
+        if (temp < 70) {
+            int8_t tempDigits[2] { int8_t(temp / 10), int8_t(temp % 10) };
+
+            int pos = sizeof(chars);
+            chars[--pos] = 'C';
+            chars[--pos] = '*';
+
+            chars[--pos] = '0' + tempDigits[1];
+
+            if (tempDigits[0] > 0)
+                chars[--pos] = '0' + tempDigits[0];
+
+            if (negative)
+                chars[--pos] = '-';
+            
+            while (pos > 0)
+                chars[--pos] = ' ';
+
+            bool redraw { false };
+            for (auto i { 0u }; i < sizeof(chars); ++i) {
+                if (prevChars[i] != chars[i]) {
+                    redraw = true;
+                    break;
+                }
+            }
+
+            if (!redraw) {
+                return true;
+            }
+        }
+
+        const uint8_t pageOffset { 1u };
+        uint8_t columnOffset { 0u };
+
+        // A run of adjacent changed characters goes out in one window and one data transaction
+        for (auto i = 0u; i < sizeof(chars); ) {
+            auto end { i };
+            while (end < sizeof(chars) && chars[end] != prevChars[end])
+                ++end;
+
+            if (end > i) {
+                if (!drawChars<ThermometerFont::Handler>(&chars[i], end - i, pageOffset, columnOffset)) {
+                    LOG(SSD1306, ERROR, "Display write failed, status: ", uint8_t(TWI::status()));
+                    goOffline();
+                    return false;
+                }
+
+                for (; i < end; ++i) {
+                    prevChars[i] = chars[i];
+                    TRACE(TemperatureDrawn, chars[i]);
+                    columnOffset += ThermometerFont::Handler::width(chars[i]);
+                }
+            }
+            else {
+                columnOffset += ThermometerFont::Handler::width(chars[i]);
+                ++i;
+            }
+        }
+
+        if (!flush()) {
+            LOG(SSD1306, ERROR, "Display write failed, status: ", uint8_t(TWI::status()));
+            goOffline();
+            return false;
+        }
+
+        return true;
+    }
+
+    /**
+     * Draws history as a sweeping line graph on the pages below the temperature: the newest reading goes
+     * to the next column and the one after it is blanked as a cursor, so only two columns are written per
+     * reading. Vertical scale follows the range of the history (at least graphMinSpan() degrees), the whole
+     * graph is redrawn when the range changes.
+     */
+    template<typename History>
+    static bool drawHistory(const History& history)
+    {
+        static_assert(History::length() >= _displayWidth, "History has to cover the whole graph");
+
+        if (!online() && !reconnect())
+            return false;
+
+        static uint16_t drawnCount { 0 };
+        static uint8_t drawnGeneration { 0 };
+        static int8_t drawnLow { 0 };
+        static int8_t drawnHigh { 0 };
+
+        // Range changes only with new readings, scanning the history is skipped until then
+        const uint16_t count { history.count() };
+        const uint16_t newSamples { uint16_t(count - drawnCount) };
+        if (newSamples == 0 && drawnGeneration == generation())
+            return true;
+
+        GraphScale scale {};
+        if (history.range(scale.low, scale.high)) {
+            if (scale.high - scale.low < graphMinSpan()) {
+                scale.low = (scale.low + scale.high - graphMinSpan()) / 2;
+                scale.high = scale.low + graphMinSpan();
+            }
+        }
+
+        const bool rescaled { scale.low != drawnLow || scale.high != drawnHigh };
+
+        const uint8_t head { uint8_t((count - 1) % _displayWidth) };
+        const uint8_t cursor { uint8_t((head + 1) % _displayWidth) };
+
+        bool drawn;
+        if (rescaled || newSamples > 1 || drawnGeneration != generation())
+            drawn = drawGraphColumns(history, scale, head, 0, _displayWidth - 1);
+        else
+            drawn = drawGraphColumns(history, scale, head, head, head) && drawGraphColumns(history, scale, head, cursor, cursor);
+
+        if (!drawn || !flush()) {
+            LOG(SSD1306, ERROR, "Graph write failed, status: ", uint8_t(TWI::status()));
+            goOffline();
+            return false;
+        }
+
+        drawnCount = count;
+        drawnGeneration = generation();
+        drawnLow = scale.low;
+        drawnHigh = scale.high;
+        return true;
+    }
+
+private:
+    static constexpr uint8_t graphFirstPage() { return 5; }
+    static constexpr uint8_t graphPages() { return _pageCount - graphFirstPage(); }
+    static constexpr uint8_t graphHeight() { return graphPages() * 8; }
+    static constexpr uint8_t graphMinSpan() { return 4; }
+
+    struct GraphScale
+    {
+        int8_t low = 0;
+        int8_t high = 0;
+
+        /**
+         * Row of the graph, counted from its top
+         */
+        uint8_t row(int8_t value) const
+        {
+            const uint8_t span { uint8_t(high - low) };
+            if (span == 0)
+                return graphHeight() - 1;
+
+            return graphHeight() - 1 - uint16_t(value - low) * (graphHeight() - 1) / span;
+        }
+    };
+
+    /**
+     * Writes columns <columnBegin, columnEnd> of the graph in one transaction, head is the column of the newest reading
+     */
+    template<typename History>
+    static bool drawGraphColumns(const History& history, const GraphScale& scale, uint8_t head, uint8_t columnBegin, uint8_t columnEnd)
+    {
+        return drawRect(columnBegin, columnEnd, graphFirstPage(), _pageCount - 1, [&](auto& out) {
+            for (uint8_t column { columnBegin }; column <= columnEnd && out.ok(); ++column) {
+                uint8_t data[graphPages()] {};
+
+                // The column after the newest reading is the cursor and stays blank
+                const uint8_t age { uint8_t((head + _displayWidth - column) % _displayWidth) };
+                const int8_t value { age < _displayWidth - 1 ? history.at(age) : History::missing() };
+
+                if (value != History::missing()) {
+                    // Vertical segment joins the reading with the previous one, which keeps steep changes visible
+                    const int8_t previous { age < _displayWidth - 2 ? history.at(age + 1) : History::missing() };
+
+                    uint8_t top { scale.row(value) };
+                    uint8_t bottom { top };
+                    if (previous != History::missing()) {
+                        const uint8_t previousRow { scale.row(previous) };
+                        if (previousRow < top)
+                            top = previousRow;
+                        else
+                            bottom = previousRow;
+                    }
+
+                    for (uint8_t row { top }; row <= bottom; ++row)
+                        data[row / 8] |= 1 << (row % 8);
+                }
+
+                out.writeBuffer(data, sizeof(data));
+            }
+        });
+    }
+
+    /**
+     * Incremented each time the display gets initialized, its RAM is cleared then and has to be drawn again
+     */
+    static uint8_t& generation()
+    {
+        static uint8_t generation { 0 };
+        return generation;
+    }
+
+    static bool& stale()
+    {
+        static bool stale { false };
+        return stale;
+    }
+
+    static bool& online()
+    {
+        static bool online { false };
+        return online;
+    }
+
+    static uint16_t& retryDelay()
+    {
+        static uint16_t delay { minRetryDelay() };
+        return delay;
+    }
+
+    static uint32_t& retryAt()
+    {
+        static uint32_t retryAt { 0 };
+        return retryAt;
+    }
+
+    static void goOffline()
+    {
+        online() = false;
+        retryAt() = Clock::millis() + retryDelay();
+
+        if (retryDelay() < maxRetryDelay() / 2)
+            retryDelay() *= 2;
+        else
+            retryDelay() = maxRetryDelay();
+    }
+
+    static bool reconnect()
+    {
+        if (int32_t(Clock::millis() - retryAt()) < 0)
+            return false;
+
+        LOG(SSD1306, INFO, "Reinitializing display");
+        return init();
+    }
+
+    /**
+     * Draws count characters side by side in one window. Each one covers its whole advance: glyph columns past
+     * it are blank and columns past the glyph are a gap, so nothing of a wider glyph drawn there before is
+     * left behind.
+     */
+    template<typename FontHandler, typename SymbolType>
+    static bool drawChars(const SymbolType* symbols, uint8_t count, uint8_t pageStart = 0u, uint8_t offset = 0u)
+    {
+        const auto pages { FontHandler::height() / 8 };
+
+        uint8_t width { 0u };
+        for (uint8_t i { 0u }; i < count; ++i)
+            width += FontHandler::width(symbols[i]);
+
+        if (width == 0)
+            return true;
+
+        return drawRect(offset, offset + width - 1, pageStart, pageStart + pages - 1, [&](auto& out) {
+            for (uint8_t i { 0u }; i < count; ++i) {
+                auto* charData = FontHandler::dataForSymbol(symbols[i]);
+                if (charData == nullptr)
+                    continue;
+
+                // Glyph starts with its advance, column-major page bytes follow
+                const uint8_t advance { charData->get() };
+                const uint8_t columns { advance < FontHandler::width() ? advance : FontHandler::width() };
+
+                out.writeFlash(charData + 1, uint16_t(pages) * columns);
+                out.fill(0x00, uint16_t(pages) * (advance - columns));
+            }
+        });
+    }
+
+    /**
+     * Calls draw(out) to fill a window column by column, a page byte after another (vertical addressing mode).
+     * out is the display itself (ScopedTWI) or the framebuffer, both offer the same write functions and ok().
+     */
+    template<typename Draw>
+    static bool drawRect(uint8_t columnBegin, uint8_t columnEnd, uint8_t pageBegin, uint8_t pageEnd, Draw draw)
+    {
+#ifdef ENABLE_SSD1306_FRAMEBUFFER
+        FrameBufferWindow window { columnBegin, columnEnd, pageBegin, pageEnd };
+        draw(window);
+        return true;
+#else
+        if (!setDrawRect(columnBegin, columnEnd, pageBegin, pageEnd))
+            return false;
+
+        {
+            ScopedTWI twi { _address };
+            twi.write(Commands::DataTag);
+            draw(twi);
+        }
+
+        return TWI::ok();
+#endif
+    }
+
+    /**
+     * Sends whatever was drawn to the framebuffer since the last flush, does nothing when drawing goes straight
+     * to the display
+     */
+    static bool flush()
+    {
+#ifdef ENABLE_SSD1306_FRAMEBUFFER
+        auto& fb { frameBuffer() };
+
+        uint8_t page { 0 };
+        while (page < _pageCount) {
+            if (!(fb.dirtyPages & (1 << page))) {
+                ++page;
+                continue;
+            }
+
+            // Following dirty pages join the window as long as that is cheaper than a window of their own
+            uint8_t lastPage { page };
+            uint8_t begin { fb.dirtyBegin[page] };
+            uint8_t end { fb.dirtyEnd[page] };
+            uint16_t cost { windowCost(end - begin + 1, 1) };
+
+            while (lastPage + 1 < _pageCount && (fb.dirtyPages & (1 << (lastPage + 1)))) {
+                const uint8_t next { uint8_t(lastPage + 1) };
+                const uint8_t joinedBegin { fb.dirtyBegin[next] < begin ? fb.dirtyBegin[next] : begin };
+                const uint8_t joinedEnd { fb.dirtyEnd[next] > end ? fb.dirtyEnd[next] : end };
+                const uint16_t joinedCost { windowCost(joinedEnd - joinedBegin + 1, next - page + 1) };
+
+                if (joinedCost > cost + windowCost(fb.dirtyEnd[next] - fb.dirtyBegin[next] + 1, 1))
+                    break;
+
+                lastPage = next;
+                begin = joinedBegin;
+                end = joinedEnd;
+                cost = joinedCost;
+            }
+
+            if (!flushWindow(begin, end, page, lastPage))
+                return false;
+
+            for (; page <= lastPage; ++page)
+                fb.dirtyPages &= ~(1 << page);
+        }
+#endif
+
+        return true;
+    }
+
+#ifdef ENABLE_SSD1306_FRAMEBUFFER
+    /**
+     * RAM copy of the display RAM, a row of _displayWidth bytes per page. A write that changes a byte marks its
+     * page dirty and extends the page's dirty column range, flush() sends just those ranges.
+     */
+    struct FrameBuffer
+    {
+        uint8_t data[_pageCount][_displayWidth];
+        uint8_t dirtyPages;
+        uint8_t dirtyBegin[_pageCount];
+        uint8_t dirtyEnd[_pageCount];
+
+        void set(uint8_t page, uint8_t column, uint8_t value)
+        {
+            auto& byte { data[page][column] };
+            if (byte == value)
+                return;
+
+            byte = value;
+
+            if (!(dirtyPages & (1 << page))) {
+                dirtyPages |= 1 << page;
+                dirtyBegin[page] = dirtyEnd[page] = column;
+            }
+            else if (column < dirtyBegin[page]) {
+                dirtyBegin[page] = column;
+            }
+            else if (column > dirtyEnd[page]) {
+                dirtyEnd[page] = column;
+            }
+        }
+    };
+
+    static FrameBuffer& frameBuffer()
+    {
+        static FrameBuffer frameBuffer {};
+        return frameBuffer;
+    }
+
+    /**
+     * Bytes on the wire for a window: column and page address commands, then the data transaction
+     */
+    static constexpr uint16_t windowCost(uint16_t width, uint8_t pages)
+    {
+        return 12 + width * pages;
+    }
+
+    static bool flushWindow(uint8_t columnBegin, uint8_t columnEnd, uint8_t pageBegin, uint8_t pageEnd)
+    {
+        auto& fb { frameBuffer() };
+
+        if (!setDrawRect(columnBegin, columnEnd, pageBegin, pageEnd))
+            return false;
+
+        {
+            ScopedTWI twi { _address };
+            twi.write(Commands::DataTag);
+
+            if (pageBegin == pageEnd) {
+                // A single page window is a plain row of the framebuffer
+                twi.writeBuffer(&fb.data[pageBegin][columnBegin], columnEnd - columnBegin + 1);
+            }
+            else {
+                for (uint8_t column { columnBegin }; column <= columnEnd && twi.ok(); ++column) {
+                    for (uint8_t page { pageBegin }; page <= pageEnd; ++page)
+                        twi.write(fb.data[page][column]);
+                }
+            }
+        }
+
+        return TWI::ok();
+    }
+
+    /**
+     * Window of the framebuffer filled the way the display fills a window, bytes past its end are dropped
+     */
+    class FrameBufferWindow
+    {
+    public:
+        FrameBufferWindow(uint8_t columnBegin, uint8_t columnEnd, uint8_t pageBegin, uint8_t pageEnd)
+            : _columnEnd(columnEnd), _pageBegin(pageBegin), _pageEnd(pageEnd), _column(columnBegin), _page(pageBegin)
+        {
+        }
+
+        bool ok() const { return true; }
+
+        bool writeBuffer(const uint8_t* data, uint16_t length)
+        {
+            while (length--)
+                put(*data++);
+            return true;
+        }
+
+        bool writeFlash(const flash<uint8_t>* data, uint16_t length)
+        {
+            auto* address { reinterpret_cast<const uint8_t*>(data) };
+            while (length--)
+                put(pgm_read_byte_postinc(address));
+            return true;
+        }
+
+        bool fill(uint8_t value, uint16_t count)
+        {
+            while (count--)
+                put(value);
+            return true;
+        }
+
+    private:
+        void put(uint8_t value)
+        {
+            if (_column > _columnEnd)
+                return;
+
+            frameBuffer().set(_page, _column, value);
+
+            if (_page++ == _pageEnd) {
+                _page = _pageBegin;
+                ++_column;
+            }
+        }
+
+        const uint8_t _columnEnd;
+        const uint8_t _pageBegin;
+        const uint8_t _pageEnd;
+        uint8_t _column;
+        uint8_t _page;
+    };
+#endif
+
+    static bool setDrawRect(uint8_t columnBegin, uint8_t columnEnd, uint8_t pageBegin, uint8_t pageEnd)
+    {
+        return sendCommand(
+            Commands::SetColumnAddress, columnBegin, columnEnd,
+            Commands::SetPageAddress, pageBegin, pageEnd
+        );
+    }
+
+    template<typename...Args>
+    inline static bool sendCommand(Args...commands)
+    {
+        {
+            ScopedTWI twi { _address };
+            twi.write(Commands::CommandTag, commands...);
+        }
+
+        return TWI::ok();
+    }
+};
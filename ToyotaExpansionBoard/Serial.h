@@ -1,123 +1,188 @@
-/*
- * Copyright (C) 2021 adrian_007, adrian-007 on o2 point pl
- *
- * This program is free software; you can redistribute it and/or modify
- * it under the terms of the GNU General Public License as published by
- * the Free Software Foundation; either version 3 of the License, or
- * (at your option) any later version.
- *
- * This program is distributed in the hope that it will be useful,
- * but WITHOUT ANY WARRANTY; without even the implied warranty of
- * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
- * GNU General Public License for more details.
- *
- * You should have received a copy of the GNU General Public License
- * along with this program; if not, write to the Free Software
- * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
- */
-
-#pragma once
-
-#ifndef F_CPU
-# error "F_CPU not defined"
-#endif
-
-#define SERIAL_BAUD_RATE 19200UL
-
-#include <avr/io.h>
-#include <stdint.h>
-
-class Serial
-{
-public:
-    Serial() = delete;
-
-    enum class Base { Bin, Oct, Dec, Hex };    
-
-    static void init()
-    {
-        UBRR0 = ((F_CPU / (8UL * SERIAL_BAUD_RATE)) - 1UL);
-        UCSR0A |= (1 << U2X0);
-        UCSR0B |= (1 << TXEN0);
-        UCSR0C |= (3 << UCSZ00);
-    }
-
-    static inline void print(uint8_t value, Base base = Base::Dec)  { print_number(value, base); }
-    static inline void print(uint16_t value, Base base = Base::Dec) { print_number(value, base); }
-    static inline void print(uint32_t value, Base base = Base::Dec) { print_number(value, base); }
-    static inline void print(uint64_t value, Base base = Base::Dec) { print_number(value, base); }
-    static inline void print(int16_t value, Base base = Base::Dec)  { print_number(value, base); }
-    static inline void print(int32_t value, Base base = Base::Dec)  { print_number(value, base); }
-    static inline void print(int64_t value, Base base = Base::Dec)  { print_number(value, base); }
-
-    static inline void print(char value)
-    {
-        while (!(UCSR0A & (1 << UDRE0)));
-        UDR0 = value;
-    }
-
-    static void print(const char* string)
-    {
-        while (*string) {
-            print(*string);
-            ++string;
-        }
-    }
-
-    template<typename...A>
-    static inline void print(auto value, A...args)
-    {
-        print(value);
-        print(args...);
-    }
-
-    template<typename...A>
-    static void println(A...args)
-    {
-        print(args..., "\r\n");
-    }
-
-private:
-    static constexpr auto baseDiv(Base base)
-    {
-        switch (base) {
-            case Base::Bin: return 2;
-            case Base::Oct: return 8;
-            case Base::Dec: return 10;
-            case Base::Hex: return 16;
-            default: return 10;
-        }
-    }
-
-    static char digitToChar(uint8_t digit)
-    {
-        static const char digits[16] {
-            '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F'
-        };
-
-        return digits[digit];
-    }
-
-    static void print_number(auto number, Base base) {
-        if (number < 0) {
-            print('-');
-            number *= -1;
-        }
-
-        auto div { baseDiv(base) };
-
-        auto d { number / div };
-        auto r { number % div };
-        if (d != 0) {
-            print_number(d, base);
-        }
-
-        print(digitToChar(r));
-    }    
-};
-
-#ifdef ENABLE_UART_LOGGING
-# define DEBUG_PRINT(...) Serial::println(__VA_ARGS__)
-#else
-# define DEBUG_PRINT(...)
-#endif
+/*
+ * Copyright (C) 2021 adrian_007, adrian-007 on o2 point pl
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#pragma once
+
+#ifndef F_CPU
+# error "F_CPU not defined"
+#endif
+
+#define SERIAL_BAUD_RATE 19200UL
+
+#include <avr/io.h>
+#include <stdint.h>
+
+#include "Board.h"
+#include "Flash.h"
+
+/**
+ * Transmit only UART. HOST_BUILD replaces the unit with outputHandler(), which sees every character sent.
+ */
+class Serial
+{
+public:
+    Serial() = delete;
+
+    enum class Base { Bin, Oct, Dec, Hex };    
+
+    static void init()
+    {
+        static_assert(Board::uartErrorPpm(SERIAL_BAUD_RATE) <= Board::uartMaxErrorPpm(), "Baud rate cannot be generated from F_CPU accurately enough");
+
+        UBRR0 = Board::uartDivisor(SERIAL_BAUD_RATE);
+        UCSR0A |= (1 << U2X0);
+        UCSR0B |= (1 << TXEN0);
+        UCSR0C |= (3 << UCSZ00);
+    }
+
+    static inline void print(uint8_t value, Base base = Base::Dec)  { print_number(value, base); }
+    static inline void print(uint16_t value, Base base = Base::Dec) { print_number(value, base); }
+    static inline void print(uint32_t value, Base base = Base::Dec) { print_number(value, base); }
+    static inline void print(uint64_t value, Base base = Base::Dec) { print_number(value, base); }
+    static inline void print(int16_t value, Base base = Base::Dec)  { print_number(value, base); }
+    static inline void print(int32_t value, Base base = Base::Dec)  { print_number(value, base); }
+    static inline void print(int64_t value, Base base = Base::Dec)  { print_number(value, base); }
+
+    static inline void print(char value)
+    {
+#ifndef HOST_BUILD
+        while (!(UCSR0A & (1 << UDRE0)));
+        UDR0 = value;
+#else
+        if (outputHandler())
+            outputHandler()(value);
+#endif
+    }
+
+    static void print(const char* string)
+    {
+        while (*string) {
+            print(*string);
+            ++string;
+        }
+    }
+
+    static void print(const flash<char>* string)
+    {
+        for (char c { string->get() }; c; c = (++string)->get()) {
+            print(c);
+        }
+    }
+
+    static inline void print() {}
+
+    template<typename...A>
+    static inline void print(auto value, A...args)
+    {
+        print(value);
+        print(args...);
+    }
+
+    template<typename...A>
+    static void println(A...args)
+    {
+        print(args...);
+        print('\r', '\n');
+    }
+
+#ifdef HOST_BUILD
+    using OutputHandler = void (*)(char);
+
+    static OutputHandler& outputHandler()
+    {
+        static OutputHandler handler { nullptr };
+        return handler;
+    }
+#endif
+
+private:
+    static constexpr auto baseDiv(Base base)
+    {
+        switch (base) {
+            case Base::Bin: return 2;
+            case Base::Oct: return 8;
+            case Base::Dec: return 10;
+            case Base::Hex: return 16;
+            default: return 10;
+        }
+    }
+
+    static char digitToChar(uint8_t digit)
+    {
+        return digit < 10 ? '0' + digit : 'A' + (digit - 10);
+    }
+
+    static void print_number(auto number, Base base) {
+        if (number < 0) {
+            print('-');
+            number *= -1;
+        }
+
+        auto div { baseDiv(base) };
+
+        auto d { number / div };
+        auto r { number % div };
+        if (d != 0) {
+            print_number(d, base);
+        }
+
+        print(digitToChar(r));
+    }    
+};
+
+#define LOG_LEVEL_NONE      0
+#define LOG_LEVEL_ERROR     1
+#define LOG_LEVEL_WARNING   2
+#define LOG_LEVEL_INFO      3
+#define LOG_LEVEL_DEBUG     4
+
+// Default level, each module can be raised or lowered separately, e.g. -DLOG_LEVEL_TWI=LOG_LEVEL_DEBUG
+#ifndef LOG_LEVEL
+# define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+#ifndef LOG_LEVEL_MAIN
+# define LOG_LEVEL_MAIN LOG_LEVEL
+#endif
+#ifndef LOG_LEVEL_TWI
+# define LOG_LEVEL_TWI LOG_LEVEL
+#endif
+#ifndef LOG_LEVEL_SSD1306
+# define LOG_LEVEL_SSD1306 LOG_LEVEL
+#endif
+#ifndef LOG_LEVEL_DS18B20
+# define LOG_LEVEL_DS18B20 LOG_LEVEL
+#endif
+#ifndef LOG_LEVEL_BUTTONS
+# define LOG_LEVEL_BUTTONS LOG_LEVEL
+#endif
+
+/**
+ * LOG(Module, Level, "message", args...) prints a line if Level is enabled for the Module. The message is placed
+ * in flash automatically, other string arguments should use FLASH_STRING. Sites below the module level are
+ * constant false branches and are removed together with their strings.
+ */
+#ifdef ENABLE_UART_LOGGING
+# define LOG(Module, Level, message, ...) \
+    do { \
+        if (LOG_LEVEL_##Level <= LOG_LEVEL_##Module) \
+            Serial::println(FLASH_STRING(message), ##__VA_ARGS__); \
+    } while (0)
+#else
+# define LOG(Module, Level, message, ...) do {} while (0)
+#endif
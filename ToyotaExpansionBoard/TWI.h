@@ -1,102 +1,361 @@
-/*
- * Copyright (C) 2021 adrian_007, adrian-007 on o2 point pl
- *
- * This program is free software; you can redistribute it and/or modify
- * it under the terms of the GNU General Public License as published by
- * the Free Software Foundation; either version 3 of the License, or
- * (at your option) any later version.
- *
- * This program is distributed in the hope that it will be useful,
- * but WITHOUT ANY WARRANTY; without even the implied warranty of
- * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
- * GNU General Public License for more details.
- *
- * You should have received a copy of the GNU General Public License
- * along with this program; if not, write to the Free Software
- * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
- */
-
-#pragma once
-
-#include <avr/io.h>
-#include <util/twi.h>
-
-#include "Serial.h"
-#include "InterruptGuard.h"
-
-struct TWI
-{
-    static constexpr auto TWIFrequency() { return 100000UL; }
-
-    static void init()
-    {
-        TWSR &= ~((1 << TWPS0) | (1 << TWPS1));
-        TWBR = ((F_CPU/TWIFrequency()) - 16) / 2;
-    }
-
-    static void start()
-    {
-        InterruptGuard ig {};
-        TWCR = (1 << TWINT) | (1 << TWEN) | (1 << TWSTA);
-        while (!(TWCR & (1 << TWINT)));
-        
-        auto status { TW_STATUS & TW_STATUS_MASK };
-        if (status != TW_START) {
-            DEBUG_PRINT("Start failed, status: ", status);
-        }
-    }
-
-    static void stop()
-    {
-        InterruptGuard ig {};
-        TWCR = (1 << TWINT) | (1 << TWEN) | (1 << TWSTO);
-        while (!(TWCR & (1 << TWSTO)));
-    }
-
-    template<typename...Args>
-    inline static void write(Args...data)
-    {
-        InterruptGuard ig {};
-        TWI::writeImpl(data...);
-    }
-
-private:
-    template<typename...Args>
-    inline static void writeImpl(uint8_t data, Args...args)
-    {
-        writeImpl(data);
-        writeImpl(args...);
-    }
-    
-    inline static void writeImpl(uint8_t data)
-    {
-        TWDR = data;
-        TWCR = (1 << TWINT) | (1 << TWEN);
-        while (!(TWCR & (1 << TWINT)));
-
-        auto status { TW_STATUS & TW_STATUS_MASK };
-        if (status != TW_MT_DATA_ACK && status != TW_MT_SLA_ACK) {
-            DEBUG_PRINT("Write failed, status: ", status);
-        }
-    }    
-};
-
-struct ScopedTWI
-{
-    ScopedTWI(uint8_t address)
-    {
-        TWI::start();
-        TWI::write(address << 1);
-    }
-
-    ~ScopedTWI()
-    {
-        TWI::stop();
-    }
-
-    template<typename...Args>
-    inline void write(Args...data)
-    {
-        TWI::write(data...);
-    }
-};
+/*
+ * Copyright (C) 2021 adrian_007, adrian-007 on o2 point pl
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#pragma once
+
+#include <avr/io.h>
+#include <util/twi.h>
+#include <util/delay.h>
+
+#include "Board.h"
+#include "Pin.h"
+#include "Serial.h"
+#include "Flash.h"
+
+/**
+ * Polled TWI master. Every wait for the hardware is bounded by waitBudget(), so a missing or glitching slave
+ * costs at most a millisecond instead of hanging the firmware until the watchdog fires.
+ *
+ * Status is sticky for the whole transaction: once an operation fails, following writes are skipped until
+ * the next start(). Interrupts stay enabled, the master drives SCL so an ISR between bytes only stretches the clock.
+ *
+ * HOST_BUILD replaces the slaves with busHandler(), which sees every START, byte and STOP and decides on ACK.
+ */
+struct TWI
+{
+    using Sda = io::Pin<io::PortC, 4>;
+    using Scl = io::Pin<io::PortC, 5>;
+
+    enum class Status : uint8_t
+    {
+        Ok,
+        Timeout,
+        StartFailed,
+        AddressNack,
+        DataNack,
+        BusError
+    };
+
+    static constexpr auto TWIFrequency() { return 100000UL; }
+
+    /**
+     * Longest wait for a single bus operation, a byte takes 90 us at 100 kHz
+     */
+    static constexpr uint16_t timeoutMicroseconds() { return 1000; }
+
+    static void init()
+    {
+        static_assert(F_CPU >= 16UL * TWIFrequency(), "F_CPU too low for the TWI frequency");
+        static_assert(Board::twiBitRate(TWIFrequency()) >= 10, "TWBR below 10 is not reliable in master mode, lower the TWI frequency");
+        static_assert(Board::twiBitRate(TWIFrequency()) <= UINT8_MAX, "F_CPU too high for the TWI frequency without prescaler");
+
+        TWSR &= ~((1 << TWPS0) | (1 << TWPS1));
+        TWBR = Board::twiBitRate(TWIFrequency());
+        TWCR = (1 << TWEN);
+    }
+
+    static Status& status()
+    {
+        static Status status { Status::Ok };
+        return status;
+    }
+
+    static bool ok()
+    {
+        return status() == Status::Ok;
+    }
+
+    static bool start()
+    {
+        status() = Status::Ok;
+
+        TWCR = (1 << TWINT) | (1 << TWEN) | (1 << TWSTA);
+#ifdef HOST_BUILD
+        hostBus(BusEvent::Start);
+#endif
+        if (!waitForInterrupt())
+            return false;
+        
+        auto status { TW_STATUS & TW_STATUS_MASK };
+        if (status != TW_START) {
+            LOG(TWI, ERROR, "Start failed, status: ", status);
+            fail(status == TW_BUS_ERROR ? Status::BusError : Status::StartFailed);
+            return false;
+        }
+
+        return true;
+    }
+
+    static bool stop()
+    {
+        TWCR = (1 << TWINT) | (1 << TWEN) | (1 << TWSTO);
+#ifdef HOST_BUILD
+        hostBus(BusEvent::Stop);
+#endif
+
+        // TWSTO is cleared by hardware once STOP was sent
+        for (auto budget { waitBudget() }; budget > 0; --budget) {
+            if (!(TWCR & (1 << TWSTO)))
+                return ok();
+        }
+
+        fail(Status::Timeout);
+        return false;
+    }
+
+    template<typename...Args>
+    inline static bool write(Args...data)
+    {
+        TWI::writeImpl(data...);
+        return ok();
+    }
+
+    /**
+     * Bulk writes stream a whole span in one loop and stop at the first failed byte
+     */
+    static bool writeBuffer(const uint8_t* data, uint16_t length)
+    {
+        if (!ok())
+            return false;
+
+        while (length-- && transmit(*data++));
+        return ok();
+    }
+
+    static bool writeFlash(const flash<uint8_t>* data, uint16_t length)
+    {
+        if (!ok())
+            return false;
+
+        auto* address { reinterpret_cast<const uint8_t*>(data) };
+        while (length-- && transmit(pgm_read_byte_postinc(address)));
+        return ok();
+    }
+
+    static bool fill(uint8_t value, uint16_t count)
+    {
+        if (!ok())
+            return false;
+
+        while (count-- && transmit(value));
+        return ok();
+    }
+
+    /**
+     * Whether the failure may have left a slave holding SDA low, see recoverBus()
+     */
+    static bool needsRecovery()
+    {
+        return status() == Status::Timeout || status() == Status::BusError;
+    }
+
+    /**
+     * Frees the bus from a slave stuck in the middle of a byte: clocks SCL up to 9 times until the slave
+     * releases SDA, then generates STOP by hand. Pins are driven open drain, low through DDR and high by
+     * the external pull-ups.
+     */
+    static void recoverBus()
+    {
+        TWCR = 0;
+
+        Sda::low();
+        Scl::low();
+        Sda::input();
+        Scl::input();
+        _delay_us(halfClockPeriod());
+
+        for (auto i { 0u }; i < 9 && !Sda::read(); ++i) {
+            Scl::output();
+            _delay_us(halfClockPeriod());
+            Scl::input();
+            _delay_us(halfClockPeriod());
+        }
+
+        // STOP: SDA goes high while SCL is high
+        Scl::output();
+        Sda::output();
+        _delay_us(halfClockPeriod());
+        Scl::input();
+        _delay_us(halfClockPeriod());
+        Sda::input();
+        _delay_us(halfClockPeriod());
+
+        LOG(TWI, WARNING, "Bus recovered, SDA: ", uint8_t(Sda::read()));
+
+        TWCR = (1 << TWEN);
+    }
+
+#ifdef HOST_BUILD
+    enum class BusEvent : uint8_t
+    {
+        Start,
+        Data,
+        Stop
+    };
+
+    /**
+     * Returns whether a Data byte (including the address) was acknowledged
+     */
+    using BusHandler = bool (*)(BusEvent event, uint8_t data);
+
+    static BusHandler& busHandler()
+    {
+        static BusHandler handler { nullptr };
+        return handler;
+    }
+#endif
+
+private:
+#ifdef HOST_BUILD
+    /**
+     * Does what the TWI unit would: reports the bus state in TWSR and clears TWSTO once STOP was sent
+     */
+    static void hostBus(BusEvent event, uint8_t data = 0)
+    {
+        const bool ack { busHandler() && busHandler()(event, data) };
+
+        switch (event) {
+            case BusEvent::Start:
+                TWSR = TW_START;
+                break;
+            case BusEvent::Data:
+                TWSR = ack ? TW_MT_DATA_ACK : TW_MT_DATA_NACK;
+                break;
+            case BusEvent::Stop:
+                TWCR = TWCR & ~(1 << TWSTO);
+                break;
+        }
+    }
+#endif
+
+    /**
+     * Cycles of a single iteration of the polling loops, approximate
+     */
+    static constexpr uint8_t waitLoopCycles() { return 8; }
+    static constexpr uint16_t waitBudget() { return F_CPU / 1000000UL * timeoutMicroseconds() / waitLoopCycles(); }
+    static constexpr double halfClockPeriod() { return 1000000.0 / TWIFrequency() / 2; }
+
+    static void fail(Status reason)
+    {
+        if (ok())
+            status() = reason;
+    }
+
+    static bool waitForInterrupt()
+    {
+        for (auto budget { waitBudget() }; budget > 0; --budget) {
+            if (TWCR & (1 << TWINT))
+                return true;
+        }
+
+        LOG(TWI, ERROR, "Timeout, status: ", uint8_t(TW_STATUS & TW_STATUS_MASK));
+        fail(Status::Timeout);
+        return false;
+    }
+
+    template<typename...Args>
+    inline static void writeImpl(uint8_t data, Args...args)
+    {
+        writeImpl(data);
+        writeImpl(args...);
+    }
+    
+    inline static void writeImpl(uint8_t data)
+    {
+        if (ok())
+            transmit(data);
+    }
+
+    static bool transmit(uint8_t data)
+    {
+        TWDR = data;
+        TWCR = (1 << TWINT) | (1 << TWEN);
+#ifdef HOST_BUILD
+        hostBus(BusEvent::Data, data);
+#endif
+        if (!waitForInterrupt())
+            return false;
+
+        auto status { TW_STATUS & TW_STATUS_MASK };
+        if (status != TW_MT_DATA_ACK && status != TW_MT_SLA_ACK) {
+            LOG(TWI, ERROR, "Write failed, status: ", status);
+
+            switch (status) {
+                case TW_MT_SLA_NACK:
+                    fail(Status::AddressNack);
+                    break;
+                case TW_MT_DATA_NACK:
+                    fail(Status::DataNack);
+                    break;
+                default:
+                    fail(Status::BusError);
+                    break;
+            }
+            return false;
+        }
+
+        return true;
+    }
+};
+
+/**
+ * Single transaction, STOP is sent when it goes out of scope. Check ok() (or the result of the last write)
+ * before relying on the data being delivered, the bus is recovered automatically after a timeout.
+ */
+struct ScopedTWI
+{
+    ScopedTWI(uint8_t address)
+    {
+        if (TWI::start())
+            TWI::write(address << 1);
+    }
+
+    ~ScopedTWI()
+    {
+        TWI::stop();
+
+        if (TWI::needsRecovery())
+            TWI::recoverBus();
+    }
+
+    bool ok() const
+    {
+        return TWI::ok();
+    }
+
+    template<typename...Args>
+    inline bool write(Args...data)
+    {
+        return TWI::write(data...);
+    }
+
+    inline bool writeBuffer(const uint8_t* data, uint16_t length)
+    {
+        return TWI::writeBuffer(data, length);
+    }
+
+    inline bool writeFlash(const flash<uint8_t>* data, uint16_t length)
+    {
+        return TWI::writeFlash(data, length);
+    }
+
+    inline bool fill(uint8_t value, uint16_t count)
+    {
+        return TWI::fill(value, count);
+    }
+};
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2021 adrian_007, adrian-007 on o2 point pl
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * Sits between DS18B20 raw readings (1/16 of degree) and the display.
+ *
+ * Raw values are smoothed with an exponential moving average (weight of a new sample = 1 / 2^SmoothingShift).
+ * Displayed value changes only when the smoothed value gets further than half a degree plus Hysteresis
+ * (in 1/16 of degree) away from the displayed one, and stays there for StableSamples consecutive samples.
+ * Values outside of <minValidTemperature(), maxValidTemperature()) are error markers - they reset the filter
+ * and are passed through as they are.
+ */
+template<uint8_t SmoothingShift = 2, uint8_t Hysteresis = 4, uint8_t StableSamples = 2>
+class TemperatureFilter
+{
+    static_assert(SmoothingShift <= 8, "Accumulator would overflow");
+    static_assert(Hysteresis < 8, "Hysteresis must be smaller than half a degree");
+    static_assert(StableSamples > 0, "At least one sample is needed to change the displayed value");
+
+public:
+    static constexpr int8_t minValidTemperature() { return -55; }
+    static constexpr int8_t maxValidTemperature() { return 70; }
+
+    /**
+     * Feeds a new raw reading, returns temperature to display in whole degrees
+     */
+    int8_t update(int16_t rawTemp)
+    {
+        if (rawTemp < minValidTemperature() * 16 || rawTemp >= maxValidTemperature() * 16) {
+            _valid = false;
+            _displayed = (int8_t)(rawTemp / 16);
+            return _displayed;
+        }
+
+        if (!_valid) {
+            _valid = true;
+            _accumulator = (int32_t)rawTemp << SmoothingShift;
+            _displayed = round(rawTemp);
+            _stableCount = 0;
+            return _displayed;
+        }
+
+        _accumulator += rawTemp - (_accumulator >> SmoothingShift);
+        const int16_t smoothed = (int16_t)(_accumulator >> SmoothingShift);
+
+        const int16_t distance = smoothed - _displayed * 16;
+        const bool beyondThreshold = distance >= 8 + Hysteresis || distance <= -(8 + Hysteresis);
+
+        if (!beyondThreshold) {
+            _stableCount = 0;
+        }
+        else if (++_stableCount >= StableSamples) {
+            _stableCount = 0;
+            _displayed = round(smoothed);
+        }
+
+        return _displayed;
+    }
+
+    int8_t value() const { return _displayed; }
+
+private:
+    static int8_t round(int16_t rawTemp)
+    {
+        // Arithmetic shift floors, adding half a degree first rounds to the nearest one
+        return (int8_t)((rawTemp + 8) >> 4);
+    }
+
+    int32_t _accumulator = 0;
+    int8_t _displayed = 90;
+    uint8_t _stableCount = 0;
+    bool _valid = false;
+};
@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2021 adrian_007, adrian-007 on o2 point pl
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * Ring of the last Length temperature readings in whole degrees, bit-packed to Bits per reading.
+ *
+ * Readings are stored relative to Offset and clamped to <Offset, Offset + 2^Bits - 2>, the all-ones code marks
+ * a missing reading (sensor error). The default 6 bits cover -20..42 degrees in 96 bytes instead of 128.
+ */
+template<uint8_t Length = 128, uint8_t Bits = 6, int8_t Offset = -20>
+class TemperatureHistory
+{
+    static_assert(Bits > 1 && Bits <= 8, "A reading has to fit into a byte");
+    static_assert(Offset + (1 << Bits) - 2 <= 127, "Range does not fit int8_t");
+
+public:
+    static constexpr uint8_t length() { return Length; }
+    static constexpr int8_t minValue() { return Offset; }
+    static constexpr int8_t maxValue() { return Offset + noData() - 1; }
+
+    /**
+     * Returned by at() for slots without a valid reading
+     */
+    static constexpr int8_t missing() { return INT8_MIN; }
+
+    void push(int8_t value, bool valid = true)
+    {
+        uint8_t code { noData() };
+        if (valid) {
+            if (value < minValue())
+                value = minValue();
+            else if (value > maxValue())
+                value = maxValue();
+            code = uint8_t(value - Offset);
+        }
+
+        store(_head, code);
+        _head = (_head + 1) % Length;
+        if (_size < Length)
+            ++_size;
+        ++_count;
+    }
+
+    uint8_t size() const { return _size; }
+
+    /**
+     * Number of readings pushed so far, wraps - only its low bits are meaningful (e.g. position on a sweep)
+     */
+    uint16_t count() const { return _count; }
+
+    /**
+     * Reading by age, 0 is the newest one
+     */
+    int8_t at(uint8_t age) const
+    {
+        if (age >= _size)
+            return missing();
+
+        const uint8_t code { load((_head + Length - 1 - age) % Length) };
+        return code == noData() ? missing() : int8_t(code + Offset);
+    }
+
+    /**
+     * Range of valid readings, returns false if there are none
+     */
+    bool range(int8_t& low, int8_t& high) const
+    {
+        bool any { false };
+        for (uint8_t age { 0 }; age < _size; ++age) {
+            const int8_t value { at(age) };
+            if (value == missing())
+                continue;
+
+            if (!any || value < low)
+                low = value;
+            if (!any || value > high)
+                high = value;
+            any = true;
+        }
+        return any;
+    }
+
+private:
+    static constexpr uint8_t noData() { return (1 << Bits) - 1; }
+
+    uint8_t load(uint8_t slot) const
+    {
+        const uint16_t bit { uint16_t(uint16_t(slot) * Bits) };
+        uint16_t word { _data[bit / 8] };
+        if (bit / 8 + 1u < sizeof(_data))
+            word |= uint16_t(_data[bit / 8 + 1]) << 8;
+        return (word >> (bit % 8)) & noData();
+    }
+
+    void store(uint8_t slot, uint8_t code)
+    {
+        const uint16_t bit { uint16_t(uint16_t(slot) * Bits) };
+        const uint16_t mask { uint16_t(noData() << (bit % 8)) };
+        const uint16_t value { uint16_t(code << (bit % 8)) };
+
+        _data[bit / 8] = (_data[bit / 8] & ~mask) | value;
+        if (bit / 8 + 1u < sizeof(_data))
+            _data[bit / 8 + 1] = (_data[bit / 8 + 1] & ~(mask >> 8)) | (value >> 8);
+    }
+
+    uint8_t _data[(uint16_t(Length) * Bits + 7) / 8] {};
+    uint8_t _head = 0;
+    uint8_t _size = 0;
+    uint16_t _count = 0;
+};
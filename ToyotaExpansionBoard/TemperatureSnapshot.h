@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) 2021 adrian_007, adrian-007 on o2 point pl
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+
+#pragma once
+
+#include <avr/eeprom.h>
+#include <stdint.h>
+
+/**
+ * Last valid temperature kept in EEPROM across power downs, shown at boot until the sensor is read.
+ *
+ * Saves are spread over a ring of slotCount() slots. Each save writes the slot after the newest one, with a
+ * sequence number one higher. The newest slot is the one not followed by its successor in sequence, a slot
+ * torn by power loss fails its check and is skipped. A save happens only when the value changed and at most
+ * once per minSaveInterval() updates, so a cell sees at most 6 / slotCount() writes an hour.
+ */
+class TemperatureSnapshot
+{
+public:
+    TemperatureSnapshot() = delete;
+
+    static constexpr uint8_t slotCount() { return 32; }
+
+    /**
+     * In update() calls, one per minute
+     */
+    static constexpr uint8_t minSaveInterval() { return 10; }
+
+    /**
+     * Finds the newest slot, returns false if EEPROM holds no snapshot (e.g. after programming)
+     */
+    static bool load(int8_t& temperature)
+    {
+        bool found { false };
+
+        for (uint8_t slot { 0 }; slot < slotCount(); ++slot) {
+            Slot current;
+            if (!read(slot, current))
+                continue;
+
+            Slot next;
+            const bool hasSuccessor { read((slot + 1) % slotCount(), next) && next.sequence == uint8_t(current.sequence + 1) };
+
+            if (!hasSuccessor) {
+                newest() = slot;
+                saved() = current;
+                found = true;
+                break;
+            }
+        }
+
+        if (found)
+            temperature = saved().temperature;
+
+        return found;
+    }
+
+    /**
+     * Called with every valid temperature reading, saves it when due
+     */
+    static void update(int8_t temperature)
+    {
+        if (sinceSave() < minSaveInterval())
+            ++sinceSave();
+
+        if (sinceSave() < minSaveInterval() || temperature == saved().temperature)
+            return;
+
+        const uint8_t slot { uint8_t((newest() + 1) % slotCount()) };
+        const Slot value { uint8_t(saved().sequence + 1), temperature, 0 };
+        write(slot, value);
+
+        newest() = slot;
+        saved() = value;
+        sinceSave() = 0;
+    }
+
+private:
+    struct Slot
+    {
+        uint8_t sequence;
+        int8_t temperature;
+        uint8_t check;
+    };
+
+    static uint8_t checkOf(const Slot& slot)
+    {
+        // Erased EEPROM (0xFF everywhere) fails the check
+        return uint8_t(slot.sequence ^ uint8_t(slot.temperature) ^ 0x5A);
+    }
+
+    static bool read(uint8_t slot, Slot& value)
+    {
+        eeprom_read_block(&value, &ring()[slot], sizeof(Slot));
+        return value.check == checkOf(value);
+    }
+
+    static void write(uint8_t slot, Slot value)
+    {
+        value.check = checkOf(value);
+        // Unchanged bytes are not written again
+        eeprom_update_block(&value, &ring()[slot], sizeof(Slot));
+    }
+
+    static Slot* ring()
+    {
+        static Slot EEMEM ring[slotCount()];
+        return ring;
+    }
+
+    static uint8_t& newest()
+    {
+        static uint8_t newest { slotCount() - 1 };
+        return newest;
+    }
+
+    static Slot& saved()
+    {
+        // Nothing saved yet: temperature no reading can have, sequence such that the first save gets 0
+        static Slot saved { 0xFF, INT8_MIN, 0 };
+        return saved;
+    }
+
+    static uint8_t& sinceSave()
+    {
+        // The first reading after boot may be saved right away
+        static uint8_t sinceSave { minSaveInterval() };
+        return sinceSave;
+    }
+};
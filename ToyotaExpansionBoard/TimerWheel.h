@@ -0,0 +1,181 @@
+/*
+ * Copyright (C) 2021 adrian_007, adrian-007 on o2 point pl
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+
+#pragma once
+
+#include <stdint.h>
+
+#include "Clock.h"
+#include "WorkQueue.h"
+
+/**
+ * Software timer driven by TimerWheel. Objects are owned by the modules using them and should have static
+ * storage duration - the wheel only links them together.
+ */
+struct Timer
+{
+    using Callback = void (*)();
+
+    constexpr Timer(Callback callback)
+        : callback { callback }
+    { }
+
+    Timer(const Timer&) = delete;
+    Timer& operator=(const Timer&) = delete;
+
+    const Callback callback;
+    uint16_t period = 0;
+    uint16_t expires = 0;
+    Timer* next = nullptr;
+    bool armed = false;
+};
+
+/**
+ * Hashed timer wheel with a millisecond resolution. Timer is kept in slot (expiration time % slotCount()),
+ * so every tick visits only timers that may be due. Clock interrupt only posts work(), callbacks are called
+ * from the main loop (see WorkQueue) - with interrupts enabled and without losing ticks while they run.
+ * Timers must not be started or stopped from interrupt handlers.
+ */
+class TimerWheel
+{
+public:
+    TimerWheel() = delete;
+
+    static constexpr uint8_t slotCount() { return 8; }
+
+    /**
+     * Arms timer to fire after delay milliseconds (at least 1), and then every period milliseconds.
+     * Period equal to 0 makes it a one-shot timer. Re-arming an armed timer restarts it.
+     */
+    static void start(Timer& timer, uint16_t delay, uint16_t period = 0)
+    {
+        if (timer.armed) {
+            unlink(timer);
+        }
+
+        timer.period = period;
+        timer.expires = now() + (delay ? delay : 1);
+        link(timer);
+    }
+
+    static void stop(Timer& timer)
+    {
+        if (timer.armed) {
+            unlink(timer);
+        }
+    }
+
+    /**
+     * Posted by the clock interrupt, catches up with the Clock one millisecond at a time
+     */
+    static Work& work()
+    {
+        static Work work { [] {
+            const uint16_t time { uint16_t(Clock::millis()) };
+
+            while (now() != time) {
+                tick(now() + 1);
+            }
+        } };
+
+        return work;
+    }
+
+private:
+    static void tick(uint16_t time)
+    {
+        static_assert((slotCount() & (slotCount() - 1)) == 0, "Slot count must be a power of two");
+
+        now() = time;
+
+        // Timers of the current slot are moved to a separate list, so that timers started or re-armed by the
+        // callbacks below land in the fresh slot list. Expired ones are removed before their callback is called.
+        auto& slot { slots()[time & (slotCount() - 1)] };
+        pending() = slot;
+        slot = nullptr;
+
+        while (Timer* timer { pending() }) {
+            pending() = timer->next;
+
+            if (timer->expires == time) {
+                timer->armed = false;
+
+                if (timer->period) {
+                    timer->expires = time + timer->period;
+                    link(*timer);
+                }
+
+                timer->callback();
+            }
+            else {
+                timer->next = slot;
+                slot = timer;
+            }
+        }
+    }
+
+    static void link(Timer& timer)
+    {
+        auto& slot { slots()[timer.expires & (slotCount() - 1)] };
+        timer.next = slot;
+        timer.armed = true;
+        slot = &timer;
+    }
+
+    static void unlink(Timer& timer)
+    {
+        if (!unlink(timer, &slots()[timer.expires & (slotCount() - 1)])) {
+            unlink(timer, &pending());
+        }
+
+        timer.next = nullptr;
+        timer.armed = false;
+    }
+
+    static bool unlink(Timer& timer, Timer** link)
+    {
+        while (*link && *link != &timer) {
+            link = &(*link)->next;
+        }
+
+        if (!*link)
+            return false;
+
+        *link = timer.next;
+        return true;
+    }
+
+    static uint16_t& now()
+    {
+        static uint16_t now { 0 };
+        return now;
+    }
+
+    static Timer*& pending()
+    {
+        static Timer* pending { nullptr };
+        return pending;
+    }
+
+    static Timer** slots()
+    {
+        static Timer* slots[slotCount()] { nullptr };
+        return slots;
+    }
+};
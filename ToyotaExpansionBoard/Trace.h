@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2021 adrian_007, adrian-007 on o2 point pl
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+
+#pragma once
+
+#if defined(ENABLE_TRACE) && defined(ENABLE_ADC_TRACE)
+# error "ADC trace uses UART exclusively, disable ENABLE_TRACE"
+#endif
+
+#include <stdint.h>
+
+#include "InterruptGuard.h"
+
+/**
+ * Tracepoints for end-to-end latency analysis (ENABLE_TRACE), analyzed on the host by tools/tracelat.py.
+ *
+ * TRACE(Event, payload) stores event id, Clock::fineTicks() timestamp and an 8-bit payload into a RAM ring,
+ * safe to use from interrupts. The ring is printed from the main loop as text lines that can be mixed
+ * with regular logging:
+ *   T <event> <timestamp> <payload>     - all hex, timestamp in 1/16 ms wrapping every 4.096 s
+ *   T FF <timestamp> <count>            - count records (saturated at 255) were dropped because the ring was
+ *                                         full, printed once the ring drains
+ *
+ * Without ENABLE_TRACE tracepoints expand to nothing.
+ */
+#ifdef ENABLE_TRACE
+
+#include "Clock.h"
+#include "Queue.h"
+#include "Serial.h"
+#include "TimerWheel.h"
+
+class Trace
+{
+public:
+    Trace() = delete;
+
+    // Ids are part of the protocol, keep tools/tracelat.py in sync
+    enum Event : uint8_t
+    {
+        ButtonPressStart    = 0x01,    // first in-range ADC sample of a press
+        ButtonPressEnd      = 0x02,    // first idle sample after a press long enough to be classified
+        ButtonClassified    = 0x03,    // payload: button
+        PotSet              = 0x04,    // tip POT set, payload: POT value
+        PotReleased         = 0x05,
+        TemperatureRead     = 0x10,    // payload: whole degrees
+        TemperatureDrawn    = 0x11,    // glyph sent to the display, payload: character
+        AdcSampleLate       = 0x20,    // ADC_vect ran too late and lost a sample, payload: gap in 1/16 ms
+        Dropped             = 0xFF
+    };
+
+    static constexpr uint16_t flushPeriod() { return 50; }
+
+    static void init()
+    {
+        static Timer flushTimer { flush };
+        TimerWheel::start(flushTimer, flushPeriod(), flushPeriod());
+    }
+
+    static void record(Event event, uint8_t payload)
+    {
+        InterruptGuard ig {};
+
+        const Record record { event, payload, Clock::fineTicks() };
+        if (!ring().push(record)) {
+            if (dropped() < 255)
+                ++dropped();
+        }
+    }
+
+    /**
+     * Timer callback, prints everything recorded so far
+     */
+    static void flush()
+    {
+        while (true) {
+            Record record;
+            {
+                InterruptGuard ig {};
+
+                auto* head { ring().peek() };
+                if (head) {
+                    record = *head;
+                    ring().pop();
+                }
+                else if (dropped()) {
+                    record = { Dropped, dropped(), Clock::fineTicks() };
+                    dropped() = 0;
+                }
+                else {
+                    return;
+                }
+            }
+
+            print(record);
+        }
+    }
+
+private:
+    struct Record
+    {
+        Event event;
+        uint8_t payload;
+        uint16_t timestamp;
+    };
+
+    static void print(const Record& record)
+    {
+        Serial::print(FLASH_STRING("T "));
+        Serial::print(uint8_t(record.event), Serial::Base::Hex);
+        Serial::print(' ');
+        Serial::print(record.timestamp, Serial::Base::Hex);
+        Serial::print(' ');
+        Serial::print(record.payload, Serial::Base::Hex);
+        Serial::println();
+    }
+
+    // 32 records, 128 bytes of RAM
+    static Queue<Record, 32>& ring()
+    {
+        static Queue<Record, 32> ring;
+        return ring;
+    }
+
+    static uint8_t& dropped()
+    {
+        static uint8_t dropped { 0 };
+        return dropped;
+    }
+};
+
+# define TRACE(event, payload) Trace::record(Trace::event, payload)
+#else
+# define TRACE(event, payload) do {} while (0)
+#endif
@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2021 adrian_007, adrian-007 on o2 point pl
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+
+#pragma once
+
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include <stdint.h>
+
+#include "InterruptGuard.h"
+#include "Queue.h"
+
+/**
+ * Unit of deferred work. Objects are owned by the modules posting them and should have static storage duration.
+ */
+struct Work
+{
+    using Callback = void (*)();
+
+    constexpr Work(Callback callback)
+        : callback { callback }
+    { }
+
+    Work(const Work&) = delete;
+    Work& operator=(const Work&) = delete;
+
+    const Callback callback;
+    volatile bool pending = false;
+};
+
+/**
+ * Bottom half for interrupt handlers: ISRs capture their data and post() work, main loop calls run() which
+ * executes posted work with interrupts enabled. Work posted again before it ran is executed only once.
+ */
+class WorkQueue
+{
+public:
+    WorkQueue() = delete;
+
+    static bool post(Work& work)
+    {
+        InterruptGuard ig {};
+
+        if (work.pending)
+            return true;
+
+        if (!queue().push(&work)) {
+            return false;
+        }
+
+        work.pending = true;
+        return true;
+    }
+
+    static void run()
+    {
+        while (true) {
+            Work* work;
+            {
+                InterruptGuard ig {};
+
+                auto** head { queue().peek() };
+                if (!head)
+                    return;
+
+                work = *head;
+                queue().pop();
+                work->pending = false;
+            }
+
+            work->callback();
+        }
+    }
+
+    /**
+     * Puts MCU to idle sleep until the next interrupt, unless there is work waiting already
+     */
+    static void waitForWork()
+    {
+        set_sleep_mode(SLEEP_MODE_IDLE);
+
+        cli();
+        if (queue().empty()) {
+            sleep_enable();
+            // Interrupts are enabled only after the next instruction, so wake up cannot be missed
+            sei();
+            sleep_cpu();
+            sleep_disable();
+        }
+        sei();
+    }
+
+private:
+    static Queue<Work*, 4>& queue()
+    {
+        static Queue<Work*, 4> queue;
+        return queue;
+    }
+};
@@ -1,110 +1,277 @@
-/*
- * Copyright (C) 2021 adrian_007, adrian-007 on o2 point pl
- *
- * This program is free software; you can redistribute it and/or modify
- * it under the terms of the GNU General Public License as published by
- * the Free Software Foundation; either version 3 of the License, or
- * (at your option) any later version.
- *
- * This program is distributed in the hope that it will be useful,
- * but WITHOUT ANY WARRANTY; without even the implied warranty of
- * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
- * GNU General Public License for more details.
- *
- * You should have received a copy of the GNU General Public License
- * along with this program; if not, write to the Free Software
- * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
- */
-
-#include "Serial.h"
-#include "MCP42100.h"
-#include "SSD1306.h"
-#include "DS18B20.h"
-#include "ADCButtons.h"
-
-#include <util/delay.h>
-#include <avr/interrupt.h>
-#include <avr/sleep.h>
-#include <avr/wdt.h>
-
-ISR(ADC_vect)
-{
-    ADCButtons::instance().newSample(ADC);
-}
-
-ISR(TIMER0_COMPA_vect)
-{
-    ADCButtons::instance().poll();
-}
-
-ISR(TIMER1_COMPA_vect)
-{
-    DS18B20::poll();
-}
-
-void disable_wdt() __attribute__((naked, used, section(".init3")));
-
-void disable_wdt()
-{
-    MCUSR = 0;
-    wdt_disable();
-}
-
-void initTimer0()
-{
-    // CTC mode
-    TCCR0A |= (1 << WGM01); 
-    // Prescaler = 1024
-    TCCR0B |= (1 << CS02) | (0 << CS01) | (1 << CS00);
-
-    OCR0A = 32;
-    // Enable COMPA interrupt
-    TIMSK0 |= (1 << OCIE0A);
-}
-
-void initTimer1()
-{
-    // CTC mode, prescaler = 256
-    TCCR1B |= (1 << WGM12) | (1 << CS12);
-    // F_CPU / 256 => interrupt every second
-    OCR1A = 15625;
-    // Enable COMPA interrupt
-    TIMSK1 |= (1 << OCIE1A);    
-}
-
-int main(void)
-{
-    Serial::init();
-    
-    DEBUG_PRINT("Initializing modules");
-
-    TWI::init();
-    SSD1306::init();
-    DS18B20::init();
-    ADCButtons::instance().init();
-
-    initTimer0();
-    initTimer1();
-
-    // Enable Watchdog
-    wdt_enable(WDTO_4S);
-
-    // Enable interrupts
-    sei();
-
-    Serial::println("Entering main loop.");
-    Serial::println();
-
-    int8_t temp { 90 };
-    while (true) {
-        {
-            InterruptGuard ig {};
-            wdt_reset();
-            temp = DS18B20::lastTemperatureValue();
-        }
-
-        SSD1306::drawTemp(temp);
-
-        _delay_ms(200);
-    }
-}
+/*
+ * Copyright (C) 2021 adrian_007, adrian-007 on o2 point pl
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include "Serial.h"
+#include "Clock.h"
+#include "TimerWheel.h"
+#include "WorkQueue.h"
+#include "MCP42100.h"
+#include "SSD1306.h"
+#include "DS18B20.h"
+#include "ADCScanner.h"
+#include "ADCButtons.h"
+#include "TemperatureFilter.h"
+#include "TemperatureHistory.h"
+#include "TemperatureSnapshot.h"
+#include "ADCTrace.h"
+#include "Trace.h"
+#include "Profiler.h"
+
+#include <util/delay.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include <avr/wdt.h>
+
+/*
+ * Interrupt priorities, most urgent first. AVR does not nest interrupts on its own, a handler blocks all the
+ * others until it returns. None of them re-enables interrupts, they are all kept short instead:
+ *
+ *   ADC_vect           - free running conversion overwrites ADC every 208 us (at 4 MHz), late handler loses
+ *                        a sample and ADCScanner attributes the next one to the wrong channel. Never preempted,
+ *                        has to stay short.
+ *   TIMER1_COMPA_vect  - clock tick and posting the timer work, a few dozen cycles. Atomic, the post needs
+ *                        interrupts disabled anyway.
+ *   TIMER0_COMPA_vect  - profiler, atomic on purpose: it measures how long other code held it off.
+ *   USART_UDRE_vect    - ADC trace, a byte per run. Level triggered, so it could only nest with UDRIE0 masked,
+ *                        not worth it for a single byte.
+ *
+ * What used to hold ADC_vect off was the main loop, not the handlers: DS18B20 ran whole 1-Wire sequences with
+ * interrupts disabled. It now disables them only for the bounded windows of a slot, at most
+ * DS18B20::longestAtomicWindow() (80 us). tools/adcbench.cpp replays the 1-Wire traffic of a temperature reading
+ * against the ADC at every phase and fails if ADC_vect, counting a pending TIMER1_COMPA_vect, could start a
+ * conversion late (about 140 us worst case at 4 MHz).
+ */
+static_assert(DS18B20::longestAtomicWindow()
+    < uint32_t(ADCScanner::adcCyclesPerConversion()) * 1000000UL / ADCScanner::adcFrequency(),
+    "1-Wire atomic window longer than an ADC conversion");
+
+#ifdef ENABLE_TRACE
+/**
+ * Two ADC conversions in Clock::fineTicks() (1/16 ms), less one tick of timestamp rounding
+ */
+constexpr uint16_t lateSampleGap()
+{
+    return uint16_t(uint32_t(ADCScanner::adcCyclesPerConversion()) * 16000UL * 2 / ADCScanner::adcFrequency()) - 1;
+}
+#endif
+
+ISR(ADC_vect)
+{
+    const uint16_t sample { ADC };
+
+#ifdef ENABLE_TRACE
+    {
+        // A gap of two conversions means a sample was overwritten before this handler ran
+        static bool sampled { false };
+        static uint16_t lastSample { 0 };
+        const uint16_t now { Clock::fineTicks() };
+        const uint16_t gap { uint16_t(now - lastSample) };
+        lastSample = now;
+
+        if (sampled && gap > lateSampleGap())
+            TRACE(AdcSampleLate, gap < 255 ? gap : 255);
+
+        sampled = true;
+    }
+#endif
+
+    if (!ADCScanner::complete(sample))
+        return;
+
+#ifdef ENABLE_ADC_TRACE
+    ADCTrace::record(sample);
+#endif
+
+    ADCButtons::instance().newSample(sample);
+}
+
+#ifdef ENABLE_ADC_TRACE
+ISR(USART_UDRE_vect)
+{
+    ADCTrace::transmit();
+}
+#endif
+
+ISR(TIMER1_COMPA_vect)
+{
+    Clock::tick();
+    WorkQueue::post(TimerWheel::work());
+}
+
+#ifdef ENABLE_PROFILER
+ISR(TIMER0_COMPA_vect, ISR_NAKED)
+{
+    Profiler::capture();
+}
+#endif
+
+void disable_wdt() __attribute__((naked, used, section(".init3")));
+
+void disable_wdt()
+{
+    MCUSR = 0;
+    wdt_disable();
+}
+
+TemperatureFilter<>& temperatureFilter()
+{
+    static TemperatureFilter<> filter {};
+    return filter;
+}
+
+TemperatureHistory<>& temperatureHistory()
+{
+    static TemperatureHistory<> history {};
+    return history;
+}
+
+/**
+ * One graph column per interval, the display shows a bit over two hours
+ */
+constexpr uint16_t historyInterval() { return 60000; }
+
+void updateHistory()
+{
+    const int8_t temp { temperatureFilter().value() };
+    const bool valid { temp >= TemperatureFilter<>::minValidTemperature() && temp < TemperatureFilter<>::maxValidTemperature() };
+
+    temperatureHistory().push(temp, valid);
+
+    if (valid)
+        TemperatureSnapshot::update(temp);
+}
+
+/**
+ * Temperature saved before the last power down, displayed (dimmed) until the first reading
+ */
+int8_t& warmStartTemperature()
+{
+    static int8_t temperature { TemperatureFilter<>::maxValidTemperature() };
+    return temperature;
+}
+
+/**
+ * AVCC in millivolts, estimated through the internal reference at its nominal 1.1 V. Not checked against a meter
+ * yet, the reference spread alone makes it good to about 10 % (see ADCScanner::bandgapMux()).
+ */
+uint16_t& supplyMillivolts()
+{
+    static uint16_t millivolts { 0 };
+    return millivolts;
+}
+
+void updateSupply(uint16_t average)
+{
+    if (average == 0)
+        return;
+
+    supplyMillivolts() = uint16_t(1100UL * 1024 / average);
+    LOG(MAIN, DEBUG, "Supply: ", supplyMillivolts(), FLASH_STRING(" mV"));
+}
+
+void updateDisplay()
+{
+    auto& filter { temperatureFilter() };
+    // No reading yet, the filter starts out showing dashes
+    static uint8_t filteredSampleCount { DS18B20::sampleCount() };
+
+    int16_t rawTemp;
+    uint8_t sampleCount;
+    {
+        InterruptGuard ig {};
+        rawTemp = DS18B20::lastRawTemperatureValue();
+        sampleCount = DS18B20::sampleCount();
+    }
+
+    static bool fresh { false };
+
+    // Feed the filter only with new samples, display is refreshed at a much higher rate
+    if (sampleCount != filteredSampleCount) {
+        filteredSampleCount = sampleCount;
+        filter.update(rawTemp);
+
+        if (!fresh) {
+            fresh = true;
+            SSD1306::setStale(false);
+        }
+    }
+
+    if (SSD1306::drawTemp(fresh ? filter.value() : warmStartTemperature()))
+        SSD1306::drawHistory(temperatureHistory());
+}
+
+int main(void)
+{
+    Serial::init();
+    
+    LOG(MAIN, INFO, "Initializing modules");
+
+    // Clock does not tick until interrupts are enabled, timers armed during init start counting from there.
+    Clock::init();
+
+    // DS18B20 starts its first conversion during init, it runs in parallel to the display bring-up.
+    TWI::init();
+    DS18B20::init();
+    SSD1306::init();
+    ADCButtons::instance().init();
+
+    // Supply voltage estimate once a second, averaged over 16 conversions
+    static ADCChannel supplyChannel { ADCScanner::bandgapMux(), 1000, 4, updateSupply };
+    ADCScanner::add(supplyChannel);
+    ADCScanner::init();
+
+    // Display the last saved temperature right away instead of dashes, the first reading comes
+    // DS18B20::readDelay() (95 ms, 9 bit conversion) after the clock starts.
+    if (TemperatureSnapshot::load(warmStartTemperature()))
+        SSD1306::setStale(true);
+
+    // Enable Watchdog
+    wdt_enable(WDTO_4S);
+
+    Serial::println(FLASH_STRING("Entering main loop."));
+    Serial::println();
+
+#ifdef ENABLE_ADC_TRACE
+    // From now on UART carries only the binary trace
+    ADCTrace::init();
+#endif
+
+    // Enable interrupts
+    sei();
+
+    static Timer displayTimer { updateDisplay };
+    TimerWheel::start(displayTimer, 1, 200);
+
+    static Timer historyTimer { updateHistory };
+    TimerWheel::start(historyTimer, historyInterval(), historyInterval());
+
+#ifdef ENABLE_TRACE
+    Trace::init();
+#endif
+
+#ifdef ENABLE_PROFILER
+    Profiler::init();
+#endif
+
+    while (true) {
+        wdt_reset();
+
+        WorkQueue::run();
+        WorkQueue::waitForWork();
+    }
+}
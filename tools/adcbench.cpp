@@ -0,0 +1,776 @@
+/*
+ * Copyright (C) 2021 adrian_007, adrian-007 on o2 point pl
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+
+/*
+ * Replay bench for the steering wheel button classifier.
+ *
+ * Feeds synthesized (or recorded, see adctrace.py) ADC streams into ADCButtons::newSample() at the real sample
+ * rate, with simulated Clock / TimerWheel / WorkQueue time, captures the MCP42100 writes through the host SPI
+ * backend and compares them with the expected POT sequence of each press. Reports classification accuracy,
+ * release-to-POT latency, hold time errors and host CPU time per sample for a sweep of noise, contact bounce
+ * and resistor tolerance drift. Scripted presses faster than the POT can play them then check the event queue
+ * (preemption by the High lane, coalesced repeats): exact order and timing of the POT pulses. Last, the 1-Wire
+ * windows with interrupts disabled are laid against the ADC to bound ADC_vect latency. The bench exits nonzero
+ * when a clean signal, the queue or the latency check fails.
+ *
+ * Latency is measured from the release, not from the start of the press: the button is told by how long it
+ * was held (short / long / extra long), so the firmware sets the POT only after the release by design and
+ * press-to-POT latency would be the hold time plus this figure.
+ *
+ * Build and run on a PC:
+ *     g++ -std=gnu++20 -O2 -DHOST_BUILD -DF_CPU=4000000UL -Itools/host -IToyotaExpansionBoard tools/adcbench.cpp -o adcbench
+ *     ./adcbench [--seed N] [--presses N]
+ *     ./adcbench --trace trace.csv [--expect Select,VolumeUp,...]
+ */
+
+// Firmware warnings are collected from its serial output
+#define ENABLE_UART_LOGGING
+
+#include "ADCButtons.h"
+#include "ADCScanner.h"
+#include "Clock.h"
+#include "DS18B20.h"
+#include "TimerWheel.h"
+#include "WorkQueue.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    // ADC runs free, a conversion takes 13 ADC clocks, ADCScanner::auxSlotLength() in every auxSlotInterval() are
+    // not ladder samples
+    constexpr uint64_t conversionNanoseconds { ADCScanner::adcCyclesPerConversion() * 1000000000ULL / ADCScanner::adcFrequency() };
+    constexpr uint16_t idleSample { 1023 };
+    constexpr uint16_t pollPeriod { 10 };
+
+    /**
+     * Expected behaviour, written down independently of ADCButtons tables: nominal ADC value of each key on the
+     * resistor ladder and the resistance the head unit expects for the short / long press function.
+     */
+    struct Key
+    {
+        const char* name;
+        uint16_t adc;
+        const char* shortName;
+        bool shortRing;
+        uint32_t shortOhms;
+        const char* longName;
+        bool longRing;
+        uint32_t longOhms;
+        bool variable;      // long function holds the POT for as long as the key was held
+    };
+
+    const Key keys[] {
+        { "Mute",       50,  "Mute",       false, 3500,  "OnOff",       false, 60000, false },
+        { "VolumeDown", 190, "VolumeDown", false, 24000, "HangUpCall",  true,  5500,  false },
+        { "VolumeUp",   360, "VolumeUp",   false, 16000, "AnswerCall",  true,  3000,  false },
+        { "Select",     520, "Select",     false, 1200,  "AddressBook", true,  1200,  false },
+        { "Next",       690, "Next",       false, 8000,  "Up",          true,  8000,  true  },
+        { "Prev",       800, "Prev",       false, 11250, "Down",        true,  11250, true  },
+    };
+
+    enum class Hold { Short, Long, VeryLong };
+
+    struct Expected
+    {
+        const char* name;
+        bool ring;
+        uint8_t potValue;
+        uint16_t holdMs;
+    };
+
+    uint8_t potValue(uint32_t ohms)
+    {
+        uint32_t value { 255 - 255 * ohms / 100000 };
+        return value ? value : 1;
+    }
+
+    Expected expected(const Key& key, Hold hold)
+    {
+        // POT is released on the first poll after the duration passed
+        if (hold == Hold::Short)
+            return { key.shortName, key.shortRing, potValue(key.shortOhms), 80 + pollPeriod };
+
+        bool longDuration { key.variable && hold == Hold::VeryLong };
+        return { key.longName, key.longRing, potValue(key.longOhms), uint16_t((longDuration ? 700 : 80) + pollPeriod) };
+    }
+
+    const char* nameOf(bool ring, uint8_t value)
+    {
+        for (const auto& key : keys) {
+            if (key.shortRing == ring && potValue(key.shortOhms) == value)
+                return key.shortName;
+            if (key.longRing == ring && potValue(key.longOhms) == value)
+                return key.longName;
+        }
+        return "?";
+    }
+
+    struct PotWrite
+    {
+        uint32_t ms;
+        uint8_t address;
+        uint8_t value;
+    };
+
+    std::vector<PotWrite>& potWrites()
+    {
+        static std::vector<PotWrite> writes;
+        return writes;
+    }
+
+    uint8_t captureSPI(uint8_t data)
+    {
+        // MCP42100::setPOT sends command then value within one chip select
+        static uint8_t command;
+        static bool haveCommand { false };
+
+        if (!haveCommand) {
+            command = data;
+            haveCommand = true;
+        }
+        else {
+            potWrites().push_back({ Clock::millis(), command, data });
+            haveCommand = false;
+        }
+        return 0xFF;
+    }
+
+    std::string& serialOutput()
+    {
+        static std::string output;
+        return output;
+    }
+
+    void captureSerial(char c)
+    {
+        serialOutput() += c;
+    }
+
+    /**
+     * Simulated MCU: advances time sample by sample, runs timer interrupts and deferred work in between
+     */
+    class Simulator
+    {
+    public:
+        void init()
+        {
+            SPI::transferHandler() = captureSPI;
+            Serial::outputHandler() = captureSerial;
+            sei();
+            Clock::init();
+            ADCButtons::instance().init();
+            potWrites().clear();
+        }
+
+        void sample(uint16_t value)
+        {
+            if (++_slot == ADCScanner::auxSlotInterval() - ADCScanner::auxSlotLength() + 1) {
+                _slot = 1;
+                _nanoseconds += conversionNanoseconds * ADCScanner::auxSlotLength();
+            }
+
+            _nanoseconds += conversionNanoseconds;
+            while (_nanoseconds >= 1000000ULL) {
+                _nanoseconds -= 1000000ULL;
+                Clock::tick();
+                WorkQueue::post(TimerWheel::work());
+                WorkQueue::run();
+            }
+
+            const auto begin { std::chrono::steady_clock::now() };
+            ADCButtons::instance().newSample(value);
+            _sampleCost += std::chrono::steady_clock::now() - begin;
+            ++_samples;
+
+            WorkQueue::run();
+        }
+
+        void idle(uint32_t ms, uint16_t value = idleSample)
+        {
+            for (auto end { now() + ms }; now() < end; )
+                sample(value);
+        }
+
+        uint32_t now() const { return Clock::millis(); }
+
+        double nanosecondsPerSample() const
+        {
+            return _samples ? std::chrono::duration<double, std::nano>(_sampleCost).count() / _samples : 0;
+        }
+
+        void resetCost()
+        {
+            _sampleCost = {};
+            _samples = 0;
+        }
+
+    private:
+        uint64_t _nanoseconds { 0 };
+        uint8_t _slot { 0 };
+        std::chrono::steady_clock::duration _sampleCost {};
+        uint64_t _samples { 0 };
+    };
+
+    struct Scenario
+    {
+        double noise;       // standard deviation, ADC counts
+        uint16_t bounce;    // contact bounce at press and release, ms
+        double drift;       // ladder tolerance, relative
+    };
+
+    struct Result
+    {
+        unsigned presses { 0 };
+        unsigned correct { 0 };
+        unsigned wrong { 0 };
+        unsigned missed { 0 };
+        unsigned spurious { 0 };
+        unsigned holdErrors { 0 };
+        std::vector<int32_t> latencies;    // release to the first POT write, presses split by noise excluded
+        double nanosecondsPerSample { 0 };
+    };
+
+    uint16_t clampSample(double value)
+    {
+        return uint16_t(std::min(1023.0, std::max(0.0, std::round(value))));
+    }
+
+    /**
+     * Splits POT writes of one press window into tip settings and checks them against expectation
+     */
+    void evaluate(const std::vector<PotWrite>& writes, const Expected& expect, uint32_t releaseMs, Result& result)
+    {
+        bool ring { false };
+        unsigned tips { 0 };
+        bool matched { false };
+
+        for (auto i { 0u }; i < writes.size(); ++i) {
+            const auto& write { writes[i] };
+
+            if (write.address == POT_RING_ADDRESS) {
+                ring = true;
+                continue;
+            }
+
+            if (write.address != POT_TIP_ADDRESS)
+                continue;
+
+            if (++tips > 1) {
+                ++result.spurious;
+                continue;
+            }
+
+            matched = write.value == expect.potValue && ring == expect.ring;
+
+            // POT set before the release means noise split the press, it counts as wrong below
+            const int32_t latency { int32_t(write.ms - releaseMs) };
+            if (latency >= 0)
+                result.latencies.push_back(latency);
+
+            for (auto j { i + 1 }; j < writes.size(); ++j) {
+                if (writes[j].address == (POT_TIP_SHUTDOWN | POT_RING_SHUTDOWN)) {
+                    auto hold { writes[j].ms - write.ms };
+                    if (hold + pollPeriod < expect.holdMs || hold > uint32_t(expect.holdMs + pollPeriod))
+                        ++result.holdErrors;
+                    break;
+                }
+            }
+        }
+
+        ++result.presses;
+        if (!tips)
+            ++result.missed;
+        else if (matched && tips == 1)
+            ++result.correct;
+        else
+            ++result.wrong;
+    }
+
+    Result run(Simulator& simulator, const Scenario& scenario, unsigned presses, std::mt19937& random)
+    {
+        Result result;
+        std::normal_distribution<double> noise { 0.0, scenario.noise > 0 ? scenario.noise : 1e-9 };
+        std::uniform_real_distribution<double> drift { -scenario.drift, scenario.drift };
+        std::bernoulli_distribution contact { 0.5 };
+
+        const auto noisy = [&](double value) { return clampSample(scenario.noise > 0 ? value + noise(random) : value); };
+
+        simulator.resetCost();
+
+        for (auto n { 0u }; n < presses; ++n) {
+            const auto& key { keys[n % (sizeof(keys) / sizeof(keys[0]))] };
+            const auto hold { Hold((n / (sizeof(keys) / sizeof(keys[0]))) % (key.variable ? 3 : 2)) };
+
+            uint32_t holdMs;
+            switch (hold) {
+                case Hold::Short:    holdMs = std::uniform_int_distribution<uint32_t> { 120, 400 }(random); break;
+                case Hold::Long:     holdMs = std::uniform_int_distribution<uint32_t> { 600, 900 }(random); break;
+                default:             holdMs = std::uniform_int_distribution<uint32_t> { 1100, 1500 }(random); break;
+            }
+
+            const double level { key.adc * (1.0 + drift(random)) };
+
+            potWrites().clear();
+
+            // Press: bouncing contact, steady level, bouncing release
+            for (auto end { simulator.now() + scenario.bounce }; simulator.now() < end; )
+                simulator.sample(contact(random) ? noisy(level) : noisy(idleSample));
+            for (auto end { simulator.now() + holdMs }; simulator.now() < end; )
+                simulator.sample(noisy(level));
+
+            // Latency is measured from the first release of the contact
+            const auto releaseMs { simulator.now() };
+
+            for (auto end { simulator.now() + scenario.bounce }; simulator.now() < end; )
+                simulator.sample(contact(random) ? noisy(level) : noisy(idleSample));
+
+            // Long enough for the longest POT step and its cool off
+            for (auto end { simulator.now() + 1500 }; simulator.now() < end; )
+                simulator.sample(noisy(idleSample));
+
+            evaluate(potWrites(), expected(key, hold), releaseMs, result);
+        }
+
+        result.nanosecondsPerSample = simulator.nanosecondsPerSample();
+        return result;
+    }
+
+    void printResult(const Scenario& scenario, Result& result)
+    {
+        auto& l { result.latencies };
+        std::sort(l.begin(), l.end());
+
+        double average { 0 };
+        for (auto v : l)
+            average += v;
+        if (!l.empty())
+            average /= l.size();
+
+        printf("%6.1f %7u %6.1f%% | %5u %7u %5u %6u %5u %7.1f%% | %5d %6.1f %5d %5d | %8.1f\n",
+            scenario.noise, scenario.bounce, scenario.drift * 100,
+            result.presses, result.correct, result.wrong, result.missed, result.spurious,
+            result.presses ? 100.0 * result.correct / result.presses : 0.0,
+            l.empty() ? 0 : l.front(), average, l.empty() ? 0 : l[l.size() * 95 / 100], l.empty() ? 0 : l.back(),
+            result.nanosecondsPerSample);
+
+        if (result.holdErrors)
+            printf("    %u presses held the POT for the wrong time\n", result.holdErrors);
+    }
+
+    int sweep(unsigned seed, unsigned presses)
+    {
+        const Scenario scenarios[] {
+            { 0,  0, 0.00 }, { 4,  0, 0.00 }, { 12, 0, 0.00 }, { 24, 0, 0.00 },
+            { 4,  3, 0.00 }, { 12, 3, 0.00 }, { 4,  8, 0.00 }, { 12, 8, 0.00 },
+            { 4,  0, 0.03 }, { 4,  0, 0.06 }, { 12, 3, 0.03 }, { 12, 3, 0.06 },
+        };
+
+        Simulator simulator;
+        simulator.init();
+        simulator.idle(100);
+
+        printf("%-22s | %-41s | %-24s | %8s\n", "", "presses", "release to POT [ms]", "host");
+        printf(" noise  bounce   drift | total correct wrong missed extra accuracy |   min    avg   p95   max |  ns/smp\n");
+
+        unsigned failures { 0 };
+        for (const auto& scenario : scenarios) {
+            std::mt19937 random { seed };
+            auto result { run(simulator, scenario, presses, random) };
+            printResult(scenario, result);
+
+            if (scenario.noise == 0 && scenario.bounce == 0 && scenario.drift == 0)
+                failures += result.presses - result.correct + result.spurious + result.holdErrors;
+        }
+
+        // Clean signal has to be classified perfectly, everything else is a measurement
+        if (failures) {
+            printf("FAIL: %u errors on a clean signal\n", failures);
+            return 1;
+        }
+
+        return 0;
+    }
+
+    /**
+     * Tip POT pulse as seen by the head unit, from setting to shutdown
+     */
+    struct Pulse
+    {
+        const char* name;
+        uint32_t setMs;
+        uint32_t releaseMs;
+    };
+
+    std::vector<Pulse> pulses(const std::vector<PotWrite>& writes)
+    {
+        std::vector<Pulse> result;
+        bool ring { false };
+
+        for (const auto& write : writes) {
+            if (write.address == POT_RING_ADDRESS) {
+                ring = true;
+            }
+            else if (write.address == POT_TIP_ADDRESS) {
+                result.push_back({ nameOf(ring, write.value), write.ms, 0 });
+            }
+            else {
+                if (!result.empty() && !result.back().releaseMs)
+                    result.back().releaseMs = write.ms;
+                ring = false;
+            }
+        }
+
+        return result;
+    }
+
+    const Key& keyNamed(const char* name)
+    {
+        for (const auto& key : keys) {
+            if (!strcmp(key.name, name))
+                return key;
+        }
+
+        fprintf(stderr, "Unknown key %s\n", name);
+        exit(2);
+    }
+
+    /**
+     * Clean press followed by an idle pause, the next press starts right after it
+     */
+    void tap(Simulator& simulator, const char* name, uint32_t holdMs, uint32_t pauseMs)
+    {
+        const auto& key { keyNamed(name) };
+        for (auto end { simulator.now() + holdMs }; simulator.now() < end; )
+            simulator.sample(key.adc);
+        simulator.idle(pauseMs);
+    }
+
+    bool checkOrder(const char* scenario, const std::vector<Pulse>& played, const std::vector<const char*>& wanted)
+    {
+        bool same { played.size() == wanted.size() };
+        for (auto i { 0u }; same && i < played.size(); ++i)
+            same = !strcmp(played[i].name, wanted[i]);
+
+        if (same)
+            return true;
+
+        printf("FAIL: %s played", scenario);
+        for (const auto& pulse : played)
+            printf(" %s", pulse.name);
+        printf(", expected");
+        for (const auto* name : wanted)
+            printf(" %s", name);
+        printf("\n");
+        return false;
+    }
+
+    /**
+     * Scripted presses faster than the POT plays them, several events wait in the lanes at once. Clean signal,
+     * the exact order and timing of the POT pulses is checked.
+     */
+    unsigned queueing()
+    {
+        unsigned failures { 0 };
+        Simulator simulator;
+        simulator.init();
+        simulator.idle(100);
+
+        // Three quick volume taps (70 ms apart, the POT pulse takes 90) merge into one Low event with two repeats,
+        // Mute is released in the middle of the second pulse. The High press drops the third pulse, the playing
+        // one finishes at full length and Mute starts on the first poll after its gap, the 120 ms cool-off.
+        potWrites().clear();
+        for (auto n { 0 }; n < 3; ++n)
+            tap(simulator, "VolumeUp", 45, 25);
+        tap(simulator, "Mute", 45, 1500);
+
+        const auto played { pulses(potWrites()) };
+        if (!checkOrder("preemption", played, { "VolumeUp", "VolumeUp", "Mute" })) {
+            ++failures;
+        }
+        else {
+            const auto hold { played[1].releaseMs - played[1].setMs };
+            const auto gap { played[2].setMs - played[1].releaseMs };
+            printf("preemption: playing VolumeUp held %u ms, Mute set %u ms after it\n", hold, gap);
+
+            if (hold != 80 + pollPeriod) {
+                printf("FAIL: playing VolumeUp held %u ms, expected %u ms\n", hold, 80 + pollPeriod);
+                ++failures;
+            }
+
+            if (gap < 120 || gap > 120 + pollPeriod) {
+                printf("FAIL: Mute set %u ms after the VolumeUp, expected the 120 ms cool-off\n", gap);
+                ++failures;
+            }
+        }
+
+        // Six taps faster than the pulses play, all of them merge into repeats of the first event. Each tap is one
+        // pulse with the short sequence gap in between, nothing is dropped.
+        potWrites().clear();
+        serialOutput().clear();
+        for (auto n { 0 }; n < 6; ++n)
+            tap(simulator, "VolumeUp", 45, 25);
+        simulator.idle(1500);
+
+        const auto repeated { pulses(potWrites()) };
+        if (!checkOrder("coalescing", repeated, { "VolumeUp", "VolumeUp", "VolumeUp", "VolumeUp", "VolumeUp", "VolumeUp" })) {
+            ++failures;
+        }
+        else {
+            uint32_t shortest { UINT32_MAX };
+            uint32_t longest { 0 };
+            for (auto i { 1u }; i < repeated.size(); ++i) {
+                shortest = std::min(shortest, repeated[i].setMs - repeated[i - 1].releaseMs);
+                longest = std::max(longest, repeated[i].setMs - repeated[i - 1].releaseMs);
+            }
+
+            printf("coalescing: 6 taps, 6 pulses, gaps %u - %u ms\n", shortest, longest);
+            if (shortest < 40 || longest > 40 + pollPeriod) {
+                printf("FAIL: gaps between coalesced pulses %u - %u ms, expected the 40 ms sequence gap\n", shortest, longest);
+                ++failures;
+            }
+        }
+
+        if (serialOutput().find("Could not queue POT event") != std::string::npos) {
+            printf("FAIL: coalescing overflowed the lane\n");
+            ++failures;
+        }
+
+        return failures;
+    }
+
+    /**
+     * Interval of the main loop with interrupts disabled, microseconds
+     */
+    struct AtomicWindow
+    {
+        uint32_t start;
+        uint32_t end;
+    };
+
+    /**
+     * 1-Wire traffic of DS18B20 laid out in time from its timing constants, interrupts are taken as free
+     */
+    class OneWireTimeline
+    {
+    public:
+        void reset()
+        {
+            _now += DS18B20::resetLowTime();
+            atomic(DS18B20::presenceSampleDelay());
+            _now += DS18B20::presenceRestTime();
+        }
+
+        void write(uint8_t value)
+        {
+            for (auto bit { 0 }; bit < 8; ++bit) {
+                const auto low { value & (1 << bit) ? DS18B20::writeOneLowTime() : DS18B20::writeZeroLowTime() };
+                atomic(low);
+                _now += DS18B20::writeSlotTime() - low;
+            }
+        }
+
+        void read(uint8_t bytes)
+        {
+            for (auto bit { 0 }; bit < bytes * 8; ++bit) {
+                atomic(DS18B20::readLowTime() + DS18B20::readSampleDelay() + DS18B20::readSampleTime());
+                _now += DS18B20::readRecoveryTime();
+            }
+        }
+
+        const std::vector<AtomicWindow>& windows() const { return _windows; }
+        uint32_t duration() const { return _now; }
+
+    private:
+        void atomic(uint32_t duration)
+        {
+            _windows.push_back({ _now, _now + duration });
+            _now += duration;
+        }
+
+        uint32_t _now { 0 };
+        std::vector<AtomicWindow> _windows;
+    };
+
+    /**
+     * Worst ADC_vect start latency while DS18B20 talks to the sensor. The ADC completes a conversion every
+     * 13 ADC clocks at any phase relative to the 1-Wire traffic, the result is lost if the handler does not
+     * read it within one conversion.
+     */
+    unsigned interruptLatency()
+    {
+        // Handler costs in CPU cycles, upper estimates from the code - there is no cycle accurate AVR model here.
+        // TIMER1_COMPA_vect has the lower vector number, if it became pending in a window it runs first.
+        constexpr uint32_t timerHandlerCycles { 200 };
+        constexpr uint32_t adcPrologueCycles { 40 };
+        constexpr uint32_t handlerMicroseconds { (timerHandlerCycles + adcPrologueCycles) * 1000000ULL / F_CPU };
+        constexpr uint32_t conversionMicroseconds { uint32_t(conversionNanoseconds / 1000) };
+
+        // Conversion started and scratchpad read, as DS18B20::poll() does them
+        OneWireTimeline timeline;
+        timeline.reset();
+        timeline.write(0xCC);
+        timeline.write(0x44);
+        timeline.reset();
+        timeline.write(0xCC);
+        timeline.write(0xBE);
+        timeline.read(9);
+
+        uint32_t worst { 0 };
+        unsigned samples { 0 };
+        unsigned lost { 0 };
+
+        for (uint32_t phase { 0 }; phase < conversionMicroseconds; ++phase) {
+            auto window { timeline.windows().begin() };
+
+            for (auto t { phase }; t < timeline.duration(); t += conversionMicroseconds) {
+                while (window != timeline.windows().end() && window->end <= t)
+                    ++window;
+
+                const bool blocked { window != timeline.windows().end() && window->start <= t };
+                const uint32_t latency { (blocked ? window->end - t : 0) + handlerMicroseconds };
+
+                worst = std::max(worst, latency);
+                ++samples;
+                if (latency >= conversionMicroseconds)
+                    ++lost;
+            }
+        }
+
+        printf("ADC_vect latency during a DS18B20 reading: longest atomic window %u us, worst start %u us "
+            "(handlers %u us), conversion %u us, %u of %u samples lost\n",
+            DS18B20::longestAtomicWindow(), worst, handlerMicroseconds, conversionMicroseconds, lost, samples);
+
+        if (lost) {
+            printf("FAIL: ADC_vect can start later than one conversion\n");
+            return 1;
+        }
+
+        return 0;
+    }
+
+    int replay(const char* path, const std::string& expect)
+    {
+        std::ifstream input { path };
+        if (!input) {
+            fprintf(stderr, "Cannot open %s\n", path);
+            return 2;
+        }
+
+        Simulator simulator;
+        simulator.init();
+
+        std::vector<uint32_t> releases;
+        bool pressed { false };
+        std::string line;
+        std::getline(input, line); // header: sample,time_ms,value
+
+        while (std::getline(input, line)) {
+            auto value { line.substr(line.rfind(',') + 1) };
+
+            // Dropped samples only advance time
+            uint16_t sample { value.empty() ? idleSample : uint16_t(std::atoi(value.c_str())) };
+            simulator.sample(sample);
+
+            bool isPressed { sample < 890 };
+            if (pressed && !isPressed)
+                releases.push_back(simulator.now());
+            pressed = isPressed;
+        }
+        simulator.idle(1500);
+
+        std::vector<std::string> detected;
+        bool ring { false };
+        for (const auto& write : potWrites()) {
+            if (write.address == POT_RING_ADDRESS) {
+                ring = true;
+            }
+            else if (write.address == POT_TIP_ADDRESS) {
+                const char* name { nameOf(ring, write.value) };
+                detected.push_back(name);
+
+                auto release { std::upper_bound(releases.begin(), releases.end(), write.ms) };
+                if (release != releases.begin())
+                    printf("%8u ms  %-12s latency %u ms\n", write.ms, name, write.ms - *(release - 1));
+                else
+                    printf("%8u ms  %-12s\n", write.ms, name);
+            }
+            else {
+                ring = false;
+            }
+        }
+
+        printf("%zu releases, %zu POT events, %.1f host ns/sample\n", releases.size(), detected.size(), simulator.nanosecondsPerSample());
+
+        if (expect.empty())
+            return 0;
+
+        std::vector<std::string> wanted;
+        std::stringstream list { expect };
+        for (std::string name; std::getline(list, name, ','); )
+            wanted.push_back(name);
+
+        unsigned correct { 0 };
+        for (auto i { 0u }; i < std::min(wanted.size(), detected.size()); ++i)
+            correct += wanted[i] == detected[i];
+
+        printf("%u / %zu expected events matched in order, %zu detected\n", correct, wanted.size(), detected.size());
+        return correct == wanted.size() && detected.size() == wanted.size() ? 0 : 1;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    unsigned seed { 1 };
+    unsigned presses { 60 };
+    const char* trace { nullptr };
+    std::string expect;
+
+    for (int i { 1 }; i < argc; ++i) {
+        if (!strcmp(argv[i], "--seed") && i + 1 < argc)
+            seed = std::atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--presses") && i + 1 < argc)
+            presses = std::atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--trace") && i + 1 < argc)
+            trace = argv[++i];
+        else if (!strcmp(argv[i], "--expect") && i + 1 < argc)
+            expect = argv[++i];
+        else {
+            fprintf(stderr, "Usage: %s [--seed N] [--presses N] | --trace trace.csv [--expect Name,Name,...]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    if (trace)
+        return replay(trace, expect);
+
+    const auto result { sweep(seed, presses) };
+    const auto failures { queueing() + interruptLatency() };
+    return failures ? 1 : result;
+}
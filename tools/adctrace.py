@@ -0,0 +1,166 @@
+#!/usr/bin/env python3
+#
+# Copyright (C) 2021 adrian_007, adrian-007 on o2 point pl
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+"""
+Decodes the raw ADC trace streamed by firmware built with ENABLE_ADC_TRACE (see ADCTrace.h).
+
+Input is either a capture file (e.g. `stty -F /dev/ttyUSB0 250000 raw && cat /dev/ttyUSB0 > trace.bin`)
+or a serial port read directly with pyserial (--port). Output is CSV with one sample per line, optionally
+followed by per-press statistics for tuning ADCButtons ranges.
+
+Examples:
+    tools/adctrace.py trace.bin -o trace.csv --presses
+    tools/adctrace.py --port /dev/ttyUSB0 --duration 30 -o trace.csv
+"""
+
+import argparse
+import sys
+import time
+
+MAX_ADC_CLOCK = 62500
+ADC_CYCLES_PER_SAMPLE = 13
+# ADCScanner::auxSlotInterval() and auxSlotLength(), conversions in each interval that go to other channels
+AUX_SLOT_INTERVAL = 16
+AUX_SLOT_LENGTH = 2
+NO_BUTTON_THRESHOLD = 890
+
+
+def adc_prescaler(f_cpu):
+    """Mirrors Board::adcClockSelect(): the fastest ADC clock not above MAX_ADC_CLOCK"""
+    select = 1
+    while select < 7 and f_cpu >> select > MAX_ADC_CLOCK:
+        select += 1
+    return 1 << select
+
+
+class Decoder:
+    def __init__(self):
+        self.synced = False
+        self.value = None
+        self.pending = []
+        self.samples = []
+        self.dropped = 0
+
+    def feed(self, data):
+        buf = self.pending + list(data)
+        i = 0
+
+        while i < len(buf):
+            byte = buf[i]
+
+            if byte == 0x80:
+                if i + 2 >= len(buf):
+                    break
+                lo, hi = buf[i + 1], buf[i + 2]
+                i += 3
+
+                if hi == 0xFF:
+                    # 0x80 n 0xFF - n samples dropped by the firmware
+                    if self.synced:
+                        self.samples.extend([None] * lo)
+                        self.dropped += lo
+                    self.synced = False
+                elif hi <= 0x03:
+                    # 0x80 lo hi - absolute sample
+                    self.value = lo | hi << 8
+                    self.synced = True
+                    self.samples.append(self.value)
+                else:
+                    # Garbage (e.g. text printed before the trace started), wait for the next absolute sample
+                    self.synced = False
+                continue
+
+            i += 1
+            if not self.synced:
+                continue
+
+            self.value += byte - 256 if byte > 0x80 else byte
+            if not 0 <= self.value <= 1023:
+                self.synced = False
+                continue
+            self.samples.append(self.value)
+
+        self.pending = buf[i:]
+
+
+def presses(samples, threshold):
+    result = []
+    start = None
+    values = []
+    for n, value in enumerate(samples + [1023]):
+        pressed = value is not None and value < threshold
+        if pressed:
+            if start is None:
+                start = n
+                values = []
+            values.append(value)
+        elif start is not None:
+            result.append((start, values))
+            start = None
+    return result
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("input", nargs="?", help="capture file, '-' for stdin")
+    parser.add_argument("--port", help="serial port to read from (requires pyserial)")
+    parser.add_argument("--baud", type=int, default=250000)
+    parser.add_argument("--duration", type=float, default=10.0, help="seconds to capture from --port")
+    parser.add_argument("--f-cpu", type=int, default=4000000, help="MCU clock, defines the sample rate")
+    parser.add_argument("-o", "--output", help="CSV output, stdout if not given")
+    parser.add_argument("--presses", action="store_true", help="print per-press statistics to stderr")
+    parser.add_argument("--threshold", type=int, default=NO_BUTTON_THRESHOLD,
+                        help="samples at or above are 'no button', see ADCButtons::maxSampleValue()")
+    args = parser.parse_args()
+
+    decoder = Decoder()
+
+    if args.port:
+        try:
+            import serial
+        except ImportError:
+            sys.exit("pyserial is required for --port, or capture to a file and decode that")
+        with serial.Serial(args.port, args.baud, timeout=0.1) as port:
+            end = time.time() + args.duration
+            while time.time() < end:
+                decoder.feed(port.read(4096))
+    elif args.input:
+        stream = sys.stdin.buffer if args.input == "-" else open(args.input, "rb")
+        with stream:
+            decoder.feed(stream.read())
+    else:
+        parser.error("either an input file or --port is required")
+
+    rate = args.f_cpu / adc_prescaler(args.f_cpu) / ADC_CYCLES_PER_SAMPLE * (AUX_SLOT_INTERVAL - AUX_SLOT_LENGTH) / AUX_SLOT_INTERVAL
+    out = open(args.output, "w") if args.output else sys.stdout
+    with out:
+        out.write("sample,time_ms,value\n")
+        for n, value in enumerate(decoder.samples):
+            out.write("%d,%.3f,%s\n" % (n, n * 1000.0 / rate, "" if value is None else value))
+
+    print("%d samples, %d dropped, %.1f Hz" % (len(decoder.samples), decoder.dropped, rate), file=sys.stderr)
+
+    if args.presses:
+        for start, values in presses(decoder.samples, args.threshold):
+            print("press at %8.1f ms: %5.1f ms, %4d samples, min / avg / max: %4d / %6.1f / %4d"
+                  % (start * 1000.0 / rate, len(values) * 1000.0 / rate, len(values),
+                     min(values), sum(values) / len(values), max(values)), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
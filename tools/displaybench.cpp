@@ -0,0 +1,238 @@
+/*
+ * Copyright (C) 2021 adrian_007, adrian-007 on o2 point pl
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+
+
+
+/*
+ * Display traffic bench.
+ *
+ * Runs scripted temperature sequences through SSD1306::drawTemp() and drawHistory() with the display replaced
+ * by SSD1306Emulator on the host TWI bus. Reports TWI transactions, bytes on the wire, estimated bus time and
+ * host CPU time per update, and checks the emulated panel:
+ *   - after each script the display is initialized again and fully redrawn, the image has to be the same as
+ *     the one left by the incremental updates,
+ *   - with --golden DIR the final image of each script is compared with DIR/<script>.pbm, --update-golden DIR
+ *     writes them (and a PNG of each for viewing) instead.
+ * Build it once as is and once with -DENABLE_SSD1306_FRAMEBUFFER to compare direct drawing with the framebuffer,
+ * both have to match the same golden images.
+ *
+ * Build and run on a PC:
+ *     g++ -std=gnu++20 -O2 -DHOST_BUILD -DF_CPU=4000000UL -Itools/host -IToyotaExpansionBoard tools/displaybench.cpp -o displaybench
+ *     ./displaybench [--golden tools/golden | --update-golden tools/golden] [--frames DIR]
+ */
+
+#include "SSD1306.h"
+#include "SSD1306Emulator.h"
+#include "TemperatureHistory.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace
+{
+    struct Traffic
+    {
+        uint32_t transactions { 0 };
+        uint32_t bytes { 0 };
+
+        /**
+         * Bus time estimate: 9 clocks per byte (with ACK), START and STOP about a clock each. Firmware gaps
+         * between bytes are not included.
+         */
+        double microseconds() const
+        {
+            return (9.0 * bytes + 2.0 * transactions) * 1000000.0 / TWI::TWIFrequency();
+        }
+    };
+
+    Traffic& traffic()
+    {
+        static Traffic traffic;
+        return traffic;
+    }
+
+    SSD1306Emulator& display()
+    {
+        static SSD1306Emulator display {};
+        return display;
+    }
+
+    bool bus(TWI::BusEvent event, uint8_t data)
+    {
+        if (event == TWI::BusEvent::Start)
+            ++traffic().transactions;
+        else if (event == TWI::BusEvent::Data)
+            ++traffic().bytes;
+
+        return display().bus(event, data);
+    }
+
+    /**
+     * Temperature per display update, a history reading is taken every historyEvery updates
+     */
+    struct Script
+    {
+        const char* name;
+        const char* file;
+        std::vector<int8_t> temperatures;
+        unsigned historyEvery;
+    };
+
+    std::vector<Script> scripts()
+    {
+        std::vector<Script> scripts;
+
+        scripts.push_back({ "steady", "steady", std::vector<int8_t>(300, 21), 10 });
+
+        Script ramp { "ramp -15..40", "ramp", {}, 5 };
+        for (int t { -15 }; t <= 40; ++t)
+            ramp.temperatures.insert(ramp.temperatures.end(), 5, int8_t(t));
+        scripts.push_back(ramp);
+
+        Script sign { "sign flips", "sign-flips", {}, 3 };
+        for (int i { 0 }; i < 100; ++i)
+            sign.temperatures.push_back(int8_t(i % 4 - 2));
+        scripts.push_back(sign);
+
+        Script error { "sensor error", "sensor-error", {}, 4 };
+        for (int i { 0 }; i < 100; ++i)
+            error.temperatures.push_back(i % 20 < 15 ? 18 : 90);
+        scripts.push_back(error);
+
+        return scripts;
+    }
+
+    struct Options
+    {
+        std::string golden;
+        bool updateGolden { false };
+        std::string frames;
+    };
+
+    /**
+     * Returns whether all image checks passed
+     */
+    bool run(const Script& script, const Options& options)
+    {
+        static TemperatureHistory<> history {};
+
+        traffic() = {};
+        std::chrono::steady_clock::duration cost {};
+        double worstMicroseconds { 0 };
+
+        for (auto i { 0u }; i < script.temperatures.size(); ++i) {
+            const int8_t temp { script.temperatures[i] };
+            if (i % script.historyEvery == 0)
+                history.push(temp, temp < 70);
+
+            const Traffic before { traffic() };
+            const auto begin { std::chrono::steady_clock::now() };
+            SSD1306::drawTemp(temp);
+            SSD1306::drawHistory(history);
+            cost += std::chrono::steady_clock::now() - begin;
+
+            const Traffic update { traffic().transactions - before.transactions, traffic().bytes - before.bytes };
+            worstMicroseconds = std::max(worstMicroseconds, update.microseconds());
+
+            if (!options.frames.empty()) {
+                char path[256];
+                snprintf(path, sizeof(path), "%s/%s-%04u.pbm", options.frames.c_str(), script.file, i);
+                display().writePbm(path);
+            }
+        }
+
+        const Traffic total { traffic() };
+        const double updates { double(script.temperatures.size()) };
+        printf("%-14s %7zu | %8.2f %9.1f %9.0f %9.0f | %8.0f |", script.name, script.temperatures.size(),
+            total.transactions / updates, total.bytes / updates, total.microseconds() / updates, worstMicroseconds,
+            std::chrono::duration<double, std::nano>(cost).count() / updates);
+
+        bool ok { true };
+        const std::string golden { options.golden + "/" + script.file };
+
+        if (options.updateGolden) {
+            ok = display().writePbm(golden + ".pbm") && display().writePng(golden + ".png");
+            printf(ok ? " written" : " write failed");
+        } else if (!options.golden.empty()) {
+            ok = display().matchesPbm(golden + ".pbm");
+            printf(ok ? " golden ok" : " golden MISMATCH");
+        }
+
+        // Drawing from scratch has to give the same image as the incremental updates
+        const auto incremental { display().frame() };
+        SSD1306::init();
+        SSD1306::drawTemp(script.temperatures.back());
+        SSD1306::drawHistory(history);
+
+        const bool redrawn { display().frame() == incremental };
+        printf(redrawn ? " redraw ok\n" : " redraw MISMATCH\n");
+
+        return ok && redrawn;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    for (int i { 1 }; i < argc; ++i) {
+        if (!strcmp(argv[i], "--golden") && i + 1 < argc) {
+            options.golden = argv[++i];
+        } else if (!strcmp(argv[i], "--update-golden") && i + 1 < argc) {
+            options.golden = argv[++i];
+            options.updateGolden = true;
+        } else if (!strcmp(argv[i], "--frames") && i + 1 < argc) {
+            options.frames = argv[++i];
+        } else {
+            fprintf(stderr, "usage: %s [--golden DIR | --update-golden DIR] [--frames DIR]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    TWI::busHandler() = bus;
+
+    traffic() = {};
+    if (!SSD1306::init()) {
+        fprintf(stderr, "Display init failed\n");
+        return 1;
+    }
+    printf("init: %u transactions, %u bytes, %.0f us on the bus\n\n", traffic().transactions, traffic().bytes,
+        traffic().microseconds());
+
+#ifdef ENABLE_SSD1306_FRAMEBUFFER
+    printf("framebuffer mode\n");
+#else
+    printf("direct mode\n");
+#endif
+    printf("script         updates | trans/up  bytes/up bus us/up  worst us | host ns/up | image\n");
+
+    bool ok { true };
+    for (const auto& script : scripts())
+        ok = run(script, options) && ok;
+
+    if (display().errors() > 0) {
+        printf("emulator: %u bytes not understood\n", display().errors());
+        ok = false;
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,390 @@
+#!/usr/bin/env python3
+#
+# Copyright (C) 2021 adrian_007, adrian-007 on o2 point pl
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+"""
+Converts BDF fonts or PNG glyph sheets into font headers usable with SSD1306::drawChars<FontHandler>.
+
+Glyphs are laid out for SSD1306 vertical addressing mode: column by column, each column is height / 8
+bytes (top page first, LSB is the topmost pixel). Every glyph is prefixed with its advance width, so
+that all glyphs of a font take the same number of bytes and symbol lookup is a single table read.
+
+Examples:
+    tools/fontgen.py tools/fonts/thermometer.bdf --name ThermometerFont -o ToyotaExpansionBoard/ThermometerFont.h
+    tools/fontgen.py sheet.png --chars "0123456789" --cell-width 6 --name DigitsFont -o DigitsFont.h
+
+PNG sheets hold glyphs in cells of --cell-width x image height (or --cell-height, wrapping into rows),
+in --chars order. Dark pixels are set, use --invert for light-on-dark sheets.
+"""
+
+import argparse
+import os
+import struct
+import sys
+import zlib
+
+LICENSE = """/*
+ * Copyright (C) 2021 adrian_007, adrian-007 on o2 point pl
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+"""
+
+
+class Glyph:
+    def __init__(self, code, advance, rows):
+        self.code = code
+        self.advance = advance
+        # rows[y][x], cell sized, 1 = pixel set
+        self.rows = rows
+
+
+def parse_bdf(path, cell_width, cell_height):
+    with open(path) as f:
+        lines = [line.rstrip("\n") for line in f]
+
+    ascent = None
+    bbox = None
+    glyphs = []
+    i = 0
+
+    while i < len(lines):
+        fields = lines[i].split()
+        i += 1
+        if not fields:
+            continue
+
+        if fields[0] == "FONTBOUNDINGBOX":
+            bbox = [int(v) for v in fields[1:5]]
+        elif fields[0] == "FONT_ASCENT":
+            ascent = int(fields[1])
+        elif fields[0] == "STARTCHAR":
+            code = None
+            advance = None
+            gbbx = None
+            bitmap = []
+
+            while i < len(lines):
+                fields = lines[i].split()
+                i += 1
+                if not fields:
+                    continue
+                if fields[0] == "ENCODING":
+                    code = int(fields[1])
+                elif fields[0] == "DWIDTH":
+                    advance = int(fields[1])
+                elif fields[0] == "BBX":
+                    gbbx = [int(v) for v in fields[1:5]]
+                elif fields[0] == "BITMAP":
+                    while lines[i].strip() != "ENDCHAR":
+                        bitmap.append(lines[i].strip())
+                        i += 1
+                elif fields[0] == "ENDCHAR":
+                    break
+
+            if code is None or code < 0 or code > 255:
+                continue
+
+            glyphs.append((code, advance, gbbx, bitmap))
+
+    if bbox is None:
+        sys.exit("%s: missing FONTBOUNDINGBOX" % path)
+    if ascent is None:
+        ascent = bbox[1] + bbox[3]
+
+    width = cell_width or bbox[0]
+    height = cell_height or (bbox[1] + 7) // 8 * 8
+
+    result = []
+    for code, advance, gbbx, bitmap in glyphs:
+        gw, gh, gx, gy = gbbx or bbox
+        rows = [[0] * width for _ in range(height)]
+        top = ascent - (gy + gh)
+
+        for r, hexrow in enumerate(bitmap):
+            bits = int(hexrow, 16) if hexrow else 0
+            total = len(hexrow) * 4
+            for c in range(gw):
+                if bits >> (total - 1 - c) & 1:
+                    x, y = gx + c, top + r
+                    if 0 <= x < width and 0 <= y < height:
+                        rows[y][x] = 1
+
+        result.append(Glyph(code, advance if advance is not None else width, rows))
+
+    return width, height, result
+
+
+def read_png(path):
+    with open(path, "rb") as f:
+        data = f.read()
+
+    if data[:8] != b"\x89PNG\r\n\x1a\n":
+        sys.exit("%s: not a PNG file" % path)
+
+    pos = 8
+    idat = b""
+    palette = None
+    while pos < len(data):
+        length, kind = struct.unpack(">I4s", data[pos:pos + 8])
+        chunk = data[pos + 8:pos + 8 + length]
+        pos += 12 + length
+        if kind == b"IHDR":
+            width, height, depth, color, _, _, interlace = struct.unpack(">IIBBBBB", chunk)
+        elif kind == b"PLTE":
+            palette = [tuple(chunk[j:j + 3]) for j in range(0, len(chunk), 3)]
+        elif kind == b"IDAT":
+            idat += chunk
+        elif kind == b"IEND":
+            break
+
+    if interlace:
+        sys.exit("%s: interlaced PNG files are not supported" % path)
+
+    channels = {0: 1, 2: 3, 3: 1, 4: 2, 6: 4}[color]
+    bits_per_pixel = channels * depth
+    stride = (width * bits_per_pixel + 7) // 8
+    bpp = max(1, bits_per_pixel // 8)
+
+    raw = zlib.decompress(idat)
+    prev = bytearray(stride)
+    luminance = []
+    offset = 0
+
+    for _ in range(height):
+        filter_type = raw[offset]
+        line = bytearray(raw[offset + 1:offset + 1 + stride])
+        offset += 1 + stride
+
+        for x in range(stride):
+            a = line[x - bpp] if x >= bpp else 0
+            b = prev[x]
+            c = prev[x - bpp] if x >= bpp else 0
+            if filter_type == 1:
+                line[x] = (line[x] + a) & 0xFF
+            elif filter_type == 2:
+                line[x] = (line[x] + b) & 0xFF
+            elif filter_type == 3:
+                line[x] = (line[x] + (a + b) // 2) & 0xFF
+            elif filter_type == 4:
+                p = a + b - c
+                pa, pb, pc = abs(p - a), abs(p - b), abs(p - c)
+                pred = a if pa <= pb and pa <= pc else (b if pb <= pc else c)
+                line[x] = (line[x] + pred) & 0xFF
+        prev = line
+
+        row = []
+        for x in range(width):
+            if depth < 8:
+                per_byte = 8 // depth
+                shift = 8 - depth * (x % per_byte + 1)
+                value = line[x // per_byte] >> shift & ((1 << depth) - 1)
+                sample = [value]
+            else:
+                step = depth // 8
+                sample = [line[(x * channels + ch) * step] for ch in range(channels)]
+
+            if color == 3:
+                r, g, b = palette[sample[0]]
+                lum = (r * 299 + g * 587 + b * 114) // 1000
+            elif color in (2, 6):
+                lum = (sample[0] * 299 + sample[1] * 587 + sample[2] * 114) // 1000
+                if color == 6 and sample[3] < 128:
+                    lum = 255
+            else:
+                lum = sample[0] * 255 // ((1 << depth) - 1) if depth < 8 else sample[0]
+                if color == 4 and sample[1] < 128:
+                    lum = 255
+            row.append(lum)
+        luminance.append(row)
+
+    return width, height, luminance
+
+
+def parse_png(path, chars, cell_width, cell_height, advance, invert):
+    if not chars:
+        sys.exit("--chars is required for PNG glyph sheets")
+    if not cell_width:
+        sys.exit("--cell-width is required for PNG glyph sheets")
+
+    image_width, image_height, luminance = read_png(path)
+    glyph_height = cell_height or image_height
+    per_row = image_width // cell_width
+    height = (glyph_height + 7) // 8 * 8
+
+    glyphs = []
+    for n, ch in enumerate(chars):
+        cx = (n % per_row) * cell_width
+        cy = (n // per_row) * glyph_height
+        if cy + glyph_height > image_height:
+            sys.exit("%s: image too small for %d glyphs" % (path, len(chars)))
+
+        rows = [[0] * cell_width for _ in range(height)]
+        for y in range(glyph_height):
+            for x in range(cell_width):
+                dark = luminance[cy + y][cx + x] < 128
+                rows[y][x] = 1 if dark != invert else 0
+
+        glyphs.append(Glyph(ord(ch), advance or cell_width + 1, rows))
+
+    return cell_width, height, glyphs
+
+
+def glyph_bytes(glyph, width, height):
+    result = [glyph.advance & 0xFF]
+    for x in range(width):
+        for page in range(height // 8):
+            value = 0
+            for bit in range(8):
+                if glyph.rows[page * 8 + bit][x]:
+                    value |= 1 << bit
+            result.append(value)
+    return result
+
+
+def symbol_literal(code):
+    if code == ord("'"):
+        return "'\\''"
+    if code == ord("\\"):
+        return "'\\\\'"
+    if 0x20 <= code < 0x7F:
+        return "'%s'" % chr(code)
+    return "0x%02X" % code
+
+
+def generate(name, source, width, height, glyphs):
+    glyphs = sorted(glyphs, key=lambda g: g.code)
+    if not glyphs:
+        sys.exit("No glyphs to generate")
+    if len(glyphs) > 255:
+        sys.exit("At most 255 glyphs are supported")
+
+    size = 1 + width * height // 8
+    first = glyphs[0].code
+    last = glyphs[-1].code
+    index = [0xFF] * (last - first + 1)
+    for n, glyph in enumerate(glyphs):
+        index[glyph.code - first] = n
+
+    out = [LICENSE]
+    out.append("// Generated by tools/fontgen.py from %s, do not edit by hand." % source)
+    out.append("")
+    out.append("#pragma once")
+    out.append("")
+    out.append('#include "Flash.h"')
+    out.append("")
+    out.append("#include <stdint.h>")
+    out.append("")
+    out.append("namespace %s" % name)
+    out.append("{")
+    out.append("    // Each glyph: advance width, then %d columns of %d byte(s), one per page" % (width, height // 8))
+    out.append("    static const flash<uint8_t> PROGMEM data[] {")
+    for glyph in glyphs:
+        data = glyph_bytes(glyph, width, height)
+        out.append("        // %s" % symbol_literal(glyph.code))
+        for i in range(0, len(data), 16):
+            out.append("        " + " ".join("0x%02X," % b for b in data[i:i + 16]))
+    out.append("    };")
+    out.append("")
+    out.append("    // Glyph number for symbols %s - %s, 0xFF if the font has no such glyph"
+               % (symbol_literal(first), symbol_literal(last)))
+    out.append("    static const flash<uint8_t> PROGMEM glyphIndex[] {")
+    for i in range(0, len(index), 16):
+        out.append("        " + " ".join("0x%02X," % b for b in index[i:i + 16]))
+    out.append("    };")
+    out.append("")
+    out.append("    struct Handler")
+    out.append("    {")
+    out.append("        static constexpr uint8_t height() { return %d; }" % height)
+    out.append("        static constexpr uint8_t width() { return %d; }" % width)
+    out.append("        static constexpr uint16_t characterBytesSize() { return %d; }" % size)
+    out.append("        static constexpr uint8_t firstSymbol() { return %s; }" % symbol_literal(first))
+    out.append("        static constexpr uint8_t lastSymbol() { return %s; }" % symbol_literal(last))
+    out.append("")
+    out.append("        static uint8_t width(char c)")
+    out.append("        {")
+    out.append("            auto* glyph = dataForSymbol(c);")
+    out.append("            return glyph ? glyph->get() : 0;")
+    out.append("        }")
+    out.append("")
+    out.append("        static const flash<uint8_t>* dataForSymbol(char c)")
+    out.append("        {")
+    out.append("            uint8_t symbol = c;")
+    out.append("            if (symbol < firstSymbol() || symbol > lastSymbol())")
+    out.append("                return nullptr;")
+    out.append("")
+    out.append("            uint8_t glyph = glyphIndex[symbol - firstSymbol()];")
+    out.append("            if (glyph == 0xFF)")
+    out.append("                return nullptr;")
+    out.append("")
+    out.append("            return &data[uint16_t(glyph) * characterBytesSize()];")
+    out.append("        }")
+    out.append("    };")
+    out.append("};")
+    out.append("")
+    return "\n".join(out)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("font", help="BDF font or PNG glyph sheet")
+    parser.add_argument("--name", required=True, help="namespace of the generated font, e.g. ThermometerFont")
+    parser.add_argument("-o", "--output", help="output header, stdout if not given")
+    parser.add_argument("--chars", help="symbols to include (BDF: subset, default all; PNG: sheet order)")
+    parser.add_argument("--cell-width", type=int, help="glyph cell width in pixels")
+    parser.add_argument("--cell-height", type=int, help="glyph cell height in pixels, rounded up to whole pages")
+    parser.add_argument("--advance", type=int, help="PNG only: advance width, default cell width + 1")
+    parser.add_argument("--invert", action="store_true", help="PNG only: light pixels are set")
+    args = parser.parse_args()
+
+    if args.font.lower().endswith(".png"):
+        width, height, glyphs = parse_png(args.font, args.chars, args.cell_width, args.cell_height,
+                                          args.advance, args.invert)
+    else:
+        width, height, glyphs = parse_bdf(args.font, args.cell_width, args.cell_height)
+        if args.chars:
+            glyphs = [g for g in glyphs if chr(g.code) in args.chars]
+
+    if height % 8 or height > 64:
+        sys.exit("Glyph height must be a multiple of 8, at most 64")
+    if width > 128:
+        sys.exit("Glyph width must be at most 128")
+
+    source = os.path.relpath(args.font, os.path.join(os.path.dirname(os.path.abspath(__file__)), ".."))
+    header = generate(args.name, source.replace(os.sep, "/"), width, height, glyphs)
+
+    if args.output:
+        with open(args.output, "w", newline="\r\n") as f:
+            f.write(header)
+    else:
+        sys.stdout.write(header)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,486 @@
+/*
+ * Copyright (C) 2021 adrian_007, adrian-007 on o2 point pl
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+
+#pragma once
+
+// Host stand-in for the SSD1306 controller, fed with the bytes TWI puts on the bus.
+
+#include "TWI.h"
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/**
+ * Models what the controller does with the TWI stream: control bytes (Co and D/C# bits), the command set used
+ * for configuration and addressing, and data writes into GDDRAM in horizontal, vertical and page addressing
+ * mode with the column / page window wrapping like on the chip. Scrolling commands are parsed and ignored.
+ *
+ * frame() renders what the panel shows (segment remap, COM scan direction, start line, inversion, display
+ * on/off), writePbm() and writePng() save it for golden image tests.
+ */
+class SSD1306Emulator
+{
+    static constexpr uint8_t _width { 128 };
+    static constexpr uint8_t _height { 64 };
+    static constexpr uint8_t _pageCount { _height / 8 };
+
+public:
+    static constexpr uint8_t width() { return _width; }
+    static constexpr uint8_t height() { return _height; }
+    static constexpr uint8_t pageCount() { return _pageCount; }
+
+    explicit SSD1306Emulator(uint8_t address = 0x3C) :
+        _address(address)
+    {
+        reset();
+    }
+
+    /**
+     * Power-on state of the controller
+     */
+    void reset()
+    {
+        memset(_gddram, 0, sizeof(_gddram));
+        _mode = Mode::Page;
+        _columnBegin = 0;
+        _columnEnd = width() - 1;
+        _pageBegin = 0;
+        _pageEnd = pageCount() - 1;
+        _column = 0;
+        _page = 0;
+        _startLine = 0;
+        _contrast = 0x7F;
+        _segmentRemap = false;
+        _comReversed = false;
+        _inverted = false;
+        _entireOn = false;
+        _on = false;
+        _state = State::Idle;
+    }
+
+    /**
+     * TWI::BusHandler compatible, returns ACK
+     */
+    bool bus(TWI::BusEvent event, uint8_t data)
+    {
+        switch (event) {
+            case TWI::BusEvent::Start:
+                _state = State::Address;
+                return true;
+
+            case TWI::BusEvent::Stop:
+                // A command cut short by STOP is dropped
+                _state = State::Idle;
+                _pending.clear();
+                return true;
+
+            case TWI::BusEvent::Data:
+                return receive(data);
+        }
+
+        return false;
+    }
+
+    uint8_t gddram(uint8_t page, uint8_t column) const { return _gddram[page][column]; }
+    uint8_t contrast() const { return _contrast; }
+    bool on() const { return _on; }
+
+    /**
+     * Bytes not understood by the model (unknown commands, data outside a transaction), should stay 0
+     */
+    uint32_t errors() const { return _errors; }
+
+    /**
+     * Pixel as seen on the panel, x from the left and y from the top
+     */
+    bool pixel(uint8_t x, uint8_t y) const
+    {
+        if (!_on)
+            return false;
+
+        if (_entireOn)
+            return true;
+
+        const uint8_t column { uint8_t(_segmentRemap ? width() - 1 - x : x) };
+        const uint8_t com { uint8_t(_comReversed ? height() - 1 - y : y) };
+        const uint8_t row { uint8_t((com + _startLine) % height()) };
+
+        return bool(_gddram[row / 8][column] & (1 << (row % 8))) != _inverted;
+    }
+
+    /**
+     * Panel image, one byte per pixel (0 or 1), row by row
+     */
+    std::vector<uint8_t> frame() const
+    {
+        std::vector<uint8_t> frame(width() * height());
+        for (uint8_t y { 0 }; y < height(); ++y) {
+            for (uint8_t x { 0 }; x < width(); ++x)
+                frame[y * width() + x] = pixel(x, y);
+        }
+
+        return frame;
+    }
+
+    /**
+     * Binary PBM (P4), lit pixels are black
+     */
+    bool writePbm(const std::string& path) const
+    {
+        FILE* file { fopen(path.c_str(), "wb") };
+        if (!file)
+            return false;
+
+        fprintf(file, "P4\n%u %u\n", width(), height());
+        for (uint8_t y { 0 }; y < height(); ++y) {
+            for (uint8_t x { 0 }; x < width(); x += 8) {
+                uint8_t bits { 0 };
+                for (uint8_t bit { 0 }; bit < 8; ++bit)
+                    bits |= pixel(x + bit, y) << (7 - bit);
+                fputc(bits, file);
+            }
+        }
+
+        return fclose(file) == 0;
+    }
+
+    /**
+     * 8-bit grayscale PNG, lit pixels are white like on the panel. Image data goes in stored (uncompressed)
+     * deflate blocks, no zlib needed.
+     */
+    bool writePng(const std::string& path) const
+    {
+        std::vector<uint8_t> raw;
+        for (uint8_t y { 0 }; y < height(); ++y) {
+            raw.push_back(0);
+            for (uint8_t x { 0 }; x < width(); ++x)
+                raw.push_back(pixel(x, y) ? 0xFF : 0x00);
+        }
+
+        std::vector<uint8_t> zlib { 0x78, 0x01 };
+        for (size_t offset { 0 }; offset < raw.size(); offset += 0xFFFF) {
+            const size_t length { std::min<size_t>(raw.size() - offset, 0xFFFF) };
+            zlib.push_back(offset + length == raw.size());
+            appendLittle16(zlib, uint16_t(length));
+            appendLittle16(zlib, uint16_t(~length));
+            zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + length);
+        }
+        appendBig32(zlib, adler32(raw));
+
+        std::vector<uint8_t> header;
+        appendBig32(header, width());
+        appendBig32(header, height());
+        header.insert(header.end(), { 8, 0, 0, 0, 0 });
+
+        std::vector<uint8_t> png { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+        appendChunk(png, "IHDR", header);
+        appendChunk(png, "IDAT", zlib);
+        appendChunk(png, "IEND", {});
+
+        FILE* file { fopen(path.c_str(), "wb") };
+        if (!file)
+            return false;
+
+        const bool written { fwrite(png.data(), 1, png.size(), file) == png.size() };
+        return fclose(file) == 0 && written;
+    }
+
+    /**
+     * Compares the panel image with a PBM written by writePbm()
+     */
+    bool matchesPbm(const std::string& path) const
+    {
+        FILE* file { fopen(path.c_str(), "rb") };
+        if (!file)
+            return false;
+
+        unsigned fileWidth { 0 }, fileHeight { 0 };
+        const bool header { fscanf(file, "P4 %u %u", &fileWidth, &fileHeight) == 2 && fgetc(file) != EOF };
+        bool match { header && fileWidth == width() && fileHeight == height() };
+
+        for (uint8_t y { 0 }; match && y < height(); ++y) {
+            for (uint8_t x { 0 }; match && x < width(); x += 8) {
+                const int bits { fgetc(file) };
+                for (uint8_t bit { 0 }; match && bit < 8; ++bit)
+                    match = bits != EOF && bool(bits & (1 << (7 - bit))) == pixel(x + bit, y);
+            }
+        }
+
+        fclose(file);
+        return match;
+    }
+
+private:
+    enum class State : uint8_t
+    {
+        Idle,
+        Address,
+        Control,
+        CommandByte,
+        DataByte,
+        CommandStream,
+        DataStream
+    };
+
+    enum class Mode : uint8_t
+    {
+        Horizontal,
+        Vertical,
+        Page
+    };
+
+    bool receive(uint8_t data)
+    {
+        switch (_state) {
+            case State::Idle:
+                ++_errors;
+                return false;
+
+            case State::Address:
+                // Write only, this model is never read
+                if (data != _address << 1) {
+                    _state = State::Idle;
+                    return false;
+                }
+                _state = State::Control;
+                return true;
+
+            case State::Control: {
+                // Co = 0: the rest of the transaction is a stream, Co = 1: a single byte and another control byte
+                const bool continuation { bool(data & 0x80) };
+                const bool isData { bool(data & 0x40) };
+
+                if (continuation)
+                    _state = isData ? State::DataByte : State::CommandByte;
+                else
+                    _state = isData ? State::DataStream : State::CommandStream;
+                return true;
+            }
+
+            case State::CommandByte:
+                command(data);
+                _state = State::Control;
+                return true;
+
+            case State::DataByte:
+                write(data);
+                _state = State::Control;
+                return true;
+
+            case State::CommandStream:
+                command(data);
+                return true;
+
+            case State::DataStream:
+                write(data);
+                return true;
+        }
+
+        return false;
+    }
+
+    /**
+     * Collects a command with its arguments and executes it once complete
+     */
+    void command(uint8_t data)
+    {
+        _pending.push_back(data);
+        if (_pending.size() < 1u + argumentCount(_pending[0]))
+            return;
+
+        execute(_pending);
+        _pending.clear();
+    }
+
+    static uint8_t argumentCount(uint8_t command)
+    {
+        switch (command) {
+            case 0x20: case 0x81: case 0x8D: case 0xA8: case 0xD3: case 0xD5: case 0xD9: case 0xDA: case 0xDB:
+                return 1;
+            case 0x21: case 0x22: case 0xA3:
+                return 2;
+            case 0x29: case 0x2A:
+                return 5;
+            case 0x26: case 0x27:
+                return 6;
+            default:
+                return 0;
+        }
+    }
+
+    void execute(const std::vector<uint8_t>& command)
+    {
+        const uint8_t code { command[0] };
+
+        if (code <= 0x0F) {
+            _column = (_column & 0xF0) | code;
+        } else if (code <= 0x1F) {
+            _column = ((code & 0x07) << 4) | (_column & 0x0F);
+        } else if (code >= 0x40 && code <= 0x7F) {
+            _startLine = code & 0x3F;
+        } else if (code >= 0xB0 && code <= 0xB7) {
+            _page = code & 0x07;
+        } else {
+            switch (code) {
+                case 0x20:
+                    switch (command[1] & 0x03) {
+                        case 0x00: _mode = Mode::Horizontal; break;
+                        case 0x01: _mode = Mode::Vertical; break;
+                        default: _mode = Mode::Page; break;
+                    }
+                    break;
+                case 0x21:
+                    _columnBegin = _column = command[1] & 0x7F;
+                    _columnEnd = command[2] & 0x7F;
+                    break;
+                case 0x22:
+                    _pageBegin = _page = command[1] & 0x07;
+                    _pageEnd = command[2] & 0x07;
+                    break;
+                case 0x81:
+                    _contrast = command[1];
+                    break;
+                case 0xA0: case 0xA1:
+                    _segmentRemap = code & 1;
+                    break;
+                case 0xA4: case 0xA5:
+                    _entireOn = code & 1;
+                    break;
+                case 0xA6: case 0xA7:
+                    _inverted = code & 1;
+                    break;
+                case 0xAE: case 0xAF:
+                    _on = code & 1;
+                    break;
+                case 0xC0: case 0xC8:
+                    _comReversed = code & 0x08;
+                    break;
+                case 0x26: case 0x27: case 0x29: case 0x2A: case 0x2E: case 0x2F: case 0xA3:
+                case 0x8D: case 0xA8: case 0xD3: case 0xD5: case 0xD9: case 0xDA: case 0xDB: case 0xE3:
+                    // Scrolling, timing and analog settings, no effect on the image
+                    break;
+                default:
+                    ++_errors;
+                    break;
+            }
+        }
+    }
+
+    void write(uint8_t data)
+    {
+        _gddram[_page][_column] = data;
+
+        switch (_mode) {
+            case Mode::Horizontal:
+                if (_column < _columnEnd) {
+                    ++_column;
+                } else {
+                    _column = _columnBegin;
+                    _page = _page < _pageEnd ? _page + 1 : _pageBegin;
+                }
+                break;
+
+            case Mode::Vertical:
+                if (_page < _pageEnd) {
+                    ++_page;
+                } else {
+                    _page = _pageBegin;
+                    _column = _column < _columnEnd ? _column + 1 : _columnBegin;
+                }
+                break;
+
+            case Mode::Page:
+                // Wraps within the page, the page does not change
+                _column = _column < width() - 1 ? _column + 1 : _columnBegin;
+                break;
+        }
+    }
+
+    static void appendLittle16(std::vector<uint8_t>& out, uint16_t value)
+    {
+        out.push_back(value & 0xFF);
+        out.push_back(value >> 8);
+    }
+
+    static void appendBig32(std::vector<uint8_t>& out, uint32_t value)
+    {
+        for (int shift { 24 }; shift >= 0; shift -= 8)
+            out.push_back(uint8_t(value >> shift));
+    }
+
+    static uint32_t adler32(const std::vector<uint8_t>& data)
+    {
+        uint32_t a { 1 }, b { 0 };
+        for (auto byte : data) {
+            a = (a + byte) % 65521;
+            b = (b + a) % 65521;
+        }
+
+        return (b << 16) | a;
+    }
+
+    static uint32_t crc32(const uint8_t* data, size_t length, uint32_t crc = 0xFFFFFFFF)
+    {
+        while (length--) {
+            crc ^= *data++;
+            for (uint8_t bit { 0 }; bit < 8; ++bit)
+                crc = crc & 1 ? (crc >> 1) ^ 0xEDB88320 : crc >> 1;
+        }
+
+        return crc;
+    }
+
+    static void appendChunk(std::vector<uint8_t>& png, const char* type, const std::vector<uint8_t>& data)
+    {
+        appendBig32(png, uint32_t(data.size()));
+
+        const size_t begin { png.size() };
+        png.insert(png.end(), type, type + 4);
+        png.insert(png.end(), data.begin(), data.end());
+
+        appendBig32(png, ~crc32(png.data() + begin, png.size() - begin));
+    }
+
+    const uint8_t _address;
+
+    uint8_t _gddram[_pageCount][_width];
+    Mode _mode;
+    uint8_t _columnBegin;
+    uint8_t _columnEnd;
+    uint8_t _pageBegin;
+    uint8_t _pageEnd;
+    uint8_t _column;
+    uint8_t _page;
+    uint8_t _startLine;
+    uint8_t _contrast;
+    bool _segmentRemap;
+    bool _comReversed;
+    bool _inverted;
+    bool _entireOn;
+    bool _on;
+
+    State _state;
+    std::vector<uint8_t> _pending;
+    uint32_t _errors { 0 };
+};
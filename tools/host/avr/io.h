@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2021 adrian_007, adrian-007 on o2 point pl
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#pragma once
+
+// Host stand-in for avr-libc, Registers are plain memory.
+
+#include <stdint.h>
+
+#define HOST_REGISTER8(name) static volatile uint8_t name;
+#define HOST_REGISTER16(name) static volatile uint16_t name;
+
+HOST_REGISTER8(PORTB) HOST_REGISTER8(DDRB) HOST_REGISTER8(PINB)
+HOST_REGISTER8(PORTC) HOST_REGISTER8(DDRC) HOST_REGISTER8(PINC)
+HOST_REGISTER8(PORTD) HOST_REGISTER8(DDRD) HOST_REGISTER8(PIND)
+HOST_REGISTER8(TCCR1A) HOST_REGISTER8(TCCR1B) HOST_REGISTER16(OCR1A) HOST_REGISTER8(TIMSK1) HOST_REGISTER16(TCNT1) HOST_REGISTER8(TIFR1)
+HOST_REGISTER8(ADMUX) HOST_REGISTER8(ADCSRA) HOST_REGISTER16(ADC)
+HOST_REGISTER8(SPCR) HOST_REGISTER8(SPSR) HOST_REGISTER8(SPDR)
+HOST_REGISTER8(TWSR) HOST_REGISTER8(TWBR) HOST_REGISTER8(TWCR) HOST_REGISTER8(TWDR)
+HOST_REGISTER16(UBRR0) HOST_REGISTER8(UCSR0A) HOST_REGISTER8(UCSR0B) HOST_REGISTER8(UCSR0C) HOST_REGISTER8(UDR0)
+HOST_REGISTER8(SREG) HOST_REGISTER8(MCUSR)
+
+#undef HOST_REGISTER8
+#undef HOST_REGISTER16
+
+enum { WGM12 = 3, CS10 = 0, CS11, CS12 };
+enum { TOIE1 = 0, OCIE1A, OCIE1B };
+enum { TOV1 = 0, OCF1A, OCF1B };
+enum { MUX0 = 0, MUX1, MUX2, MUX3, ADLAR = 5, REFS0, REFS1 };
+enum { ADPS0 = 0, ADPS1, ADPS2, ADIE, ADIF, ADATE, ADSC, ADEN };
+enum { SPR0 = 0, SPR1, CPHA, CPOL, MSTR, DORD, SPE, SPIE };
+enum { SPI2X = 0, SPIF = 7 };
+enum { TWPS0 = 0, TWPS1 };
+enum { TWIE = 0, TWEN = 2, TWWC, TWSTO, TWSTA, TWEA, TWINT };
+enum { MPCM0 = 0, U2X0, UPE0, DOR0, FE0, UDRE0, TXC0, RXC0 };
+enum { TXB80 = 0, RXB80, UCSZ02, TXEN0, RXEN0, UDRIE0, TXCIE0, RXCIE0 };
+enum { UCPOL0 = 0, UCSZ00, UCSZ01 };
@@ -0,0 +1,175 @@
+#!/usr/bin/env python3
+#
+# Copyright (C) 2021 adrian_007, adrian-007 on o2 point pl
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+
+"""
+Maps the PC histogram printed by firmware built with ENABLE_PROFILER (see Profiler.h) to functions of the ELF image.
+
+Input is the UART log (19200 baud), e.g. `stty -F /dev/ttyUSB0 19200 raw && cat /dev/ttyUSB0 > profile.log`, or a
+serial port read directly with pyserial (--port). All dumps in the input are summed. A histogram bucket that
+spans several functions is split between them in proportion to the bytes each one covers, so keep
+PROFILER_BUCKET_SHIFT small when hunting inside short functions.
+
+Only the ELF symbol table is read, no other tools are required. Names are demangled with c++filt when available.
+
+Examples:
+    tools/profile.py ToyotaExpansionBoard/Debug/ToyotaExpansionBoard.elf profile.log
+    tools/profile.py firmware.elf --port /dev/ttyUSB0 --duration 60 --top 20
+"""
+
+import argparse
+import shutil
+import struct
+import subprocess
+import sys
+import time
+
+STT_FUNC = 2
+STT_NOTYPE = 0
+SHT_SYMTAB = 2
+
+
+def read_symbols(path):
+    """Returns sorted (address, size, name) of functions from a 32-bit little endian ELF file (avr-gcc output)."""
+    with open(path, "rb") as f:
+        data = f.read()
+
+    if data[:4] != b"\x7fELF" or data[4] != 1 or data[5] != 1:
+        sys.exit("%s is not a 32-bit little endian ELF file" % path)
+
+    shoff, = struct.unpack_from("<I", data, 0x20)
+    shentsize, shnum = struct.unpack_from("<HH", data, 0x2E)
+
+    sections = [struct.unpack_from("<IIIIIIIIII", data, shoff + i * shentsize) for i in range(shnum)]
+
+    symbols = []
+    for _, sh_type, _, _, offset, size, link, _, _, entsize in sections:
+        if sh_type != SHT_SYMTAB:
+            continue
+        strtab = sections[link]
+        strings = data[strtab[4]:strtab[4] + strtab[5]]
+        for i in range(size // entsize):
+            name, value, sym_size, info, _, shndx = struct.unpack_from("<IIIBBH", data, offset + i * entsize)
+            kind = info & 0x0F
+            if kind != STT_FUNC or shndx == 0:
+                continue
+            end = strings.index(b"\0", name)
+            symbols.append((value, sym_size, strings[name:end].decode("ascii", "replace")))
+
+    symbols.sort()
+    return symbols
+
+
+def demangle(names):
+    tool = shutil.which("avr-c++filt") or shutil.which("c++filt")
+    if not tool or not names:
+        return {name: name for name in names}
+    result = subprocess.run([tool], input="\n".join(names), capture_output=True, text=True)
+    return dict(zip(names, result.stdout.splitlines()))
+
+
+def parse(lines):
+    """Sums all dumps, returns (bucket shift, total samples, blocked samples, {bucket: count})."""
+    shift = None
+    total = blocked = 0
+    buckets = {}
+    for line in lines:
+        fields = line.strip().split()
+        try:
+            if len(fields) == 4 and fields[0] == "PH":
+                dump_shift, dump_total, dump_blocked = (int(f, 16) for f in fields[1:])
+                if shift is not None and dump_shift != shift:
+                    sys.exit("Input mixes bucket sizes, capture one firmware build at a time")
+                shift = dump_shift
+                total += dump_total
+                blocked += dump_blocked
+            elif len(fields) == 3 and fields[0] == "P" and shift is not None:
+                bucket, count = (int(f, 16) for f in fields[1:])
+                buckets[bucket] = buckets.get(bucket, 0) + count
+        except ValueError:
+            continue
+    return shift, total, blocked, buckets
+
+
+def attribute(symbols, shift, buckets):
+    """Splits every bucket between the functions it overlaps, returns {name: samples}."""
+    result = {}
+    size = 1 << shift
+    for bucket, count in buckets.items():
+        begin, end = bucket * size, (bucket + 1) * size
+        overlaps = []
+        for address, sym_size, name in symbols:
+            overlap = min(end, address + max(sym_size, 2)) - max(begin, address)
+            if overlap > 0:
+                overlaps.append((name, overlap))
+        covered = sum(o for _, o in overlaps)
+        if covered < size:
+            overlaps.append(("[0x%04X-0x%04X unknown]" % (begin, end - 1), size - covered))
+            covered = size
+        for name, overlap in overlaps:
+            result[name] = result.get(name, 0) + count * overlap / covered
+    return result
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("elf", help="firmware image the profile was taken from")
+    parser.add_argument("input", nargs="?", help="captured log, '-' for stdin")
+    parser.add_argument("--port", help="serial port to read from (requires pyserial)")
+    parser.add_argument("--baud", type=int, default=19200)
+    parser.add_argument("--duration", type=float, default=30.0, help="seconds to capture from --port")
+    parser.add_argument("--top", type=int, default=30, help="number of functions to print")
+    args = parser.parse_args()
+
+    if args.port:
+        try:
+            import serial
+        except ImportError:
+            sys.exit("pyserial is required for --port, or capture to a file and decode that")
+        lines = []
+        with serial.Serial(args.port, args.baud, timeout=0.1) as port:
+            end = time.time() + args.duration
+            while time.time() < end:
+                lines.extend(l.decode("ascii", "replace") for l in port.readlines())
+    elif args.input:
+        stream = sys.stdin if args.input == "-" else open(args.input, errors="replace")
+        with stream:
+            lines = stream.readlines()
+    else:
+        parser.error("either an input file or --port is required")
+
+    shift, total, blocked, buckets = parse(lines)
+    if shift is None or not total:
+        sys.exit("No profiler dumps found in the input")
+
+    symbols = read_symbols(args.elf)
+    samples = attribute(symbols, shift, buckets)
+    names = demangle([name for name in samples if not name.startswith("[")])
+
+    rows = sorted(samples.items(), key=lambda item: -item[1])
+    rows.insert(0, ("[blocked: other ISR or interrupts disabled]", blocked))
+    rows.sort(key=lambda item: -item[1])
+
+    print("%d samples, bucket %d bytes" % (total, 1 << shift))
+    print("%9s %7s  %s" % ("samples", "%", "function"))
+    for name, count in rows[:args.top]:
+        print("%9.1f %6.2f%%  %s" % (count, 100.0 * count / total, names.get(name, name)))
+
+
+if __name__ == "__main__":
+    main()
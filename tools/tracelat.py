@@ -0,0 +1,181 @@
+#!/usr/bin/env python3
+#
+# Copyright (C) 2021 adrian_007, adrian-007 on o2 point pl
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+
+"""
+Computes latency distributions from tracepoints printed by firmware built with ENABLE_TRACE (see Trace.h).
+
+Input is the UART log (19200 baud), e.g. `stty -F /dev/ttyUSB0 19200 raw && cat /dev/ttyUSB0 > trace.log`, or a
+serial port read directly with pyserial (--port). Lines other than `T <event> <timestamp> <payload>` are ignored,
+so tracing can be combined with ENABLE_UART_LOGGING.
+
+A pair START:END measures the time from START to the next END. With --first the earliest START since the previous
+END is used (e.g. first contact of a bouncing button), otherwise the latest one (e.g. the temperature reading that
+actually caused the redraw). Dropped records break all pairs in progress.
+
+Examples:
+    tools/tracelat.py trace.log
+    tools/tracelat.py trace.log --pair ButtonPressEnd:PotSet --pair TemperatureRead:TemperatureDrawn
+    tools/tracelat.py --port /dev/ttyUSB0 --duration 60 --events
+"""
+
+import argparse
+import sys
+import time
+
+# Keep in sync with Trace::Event
+EVENTS = {
+    0x01: "ButtonPressStart",
+    0x02: "ButtonPressEnd",
+    0x03: "ButtonClassified",
+    0x04: "PotSet",
+    0x05: "PotReleased",
+    0x10: "TemperatureRead",
+    0x11: "TemperatureDrawn",
+    0x20: "AdcSampleLate",
+    0xFF: "Dropped",
+}
+IDS = {name: event for event, name in EVENTS.items()}
+
+TICKS_PER_MS = 16
+TIMESTAMP_WRAP = 1 << 16
+
+DEFAULT_PAIRS = [
+    ("ButtonPressStart", "PotSet", True),
+    ("ButtonPressEnd", "PotSet", False),
+    ("ButtonClassified", "PotSet", False),
+    ("TemperatureRead", "TemperatureDrawn", False),
+]
+
+
+def parse(lines):
+    """Yields (event, time_ms, payload), timestamps unwrapped assuming no gap longer than 4 s between records."""
+    base = 0
+    last = None
+    for line in lines:
+        fields = line.strip().split()
+        if len(fields) != 4 or fields[0] != "T":
+            continue
+        try:
+            event, timestamp, payload = (int(f, 16) for f in fields[1:])
+        except ValueError:
+            continue
+
+        if last is not None and timestamp < last:
+            base += TIMESTAMP_WRAP
+        last = timestamp
+        yield event, (base + timestamp) / TICKS_PER_MS, payload
+
+
+def latencies(records, start, end, first):
+    result = []
+    pending = None
+    for event, t, _ in records:
+        if event == IDS["Dropped"]:
+            pending = None
+        elif event == start:
+            if pending is None or not first:
+                pending = t
+        elif event == end and pending is not None:
+            result.append(t - pending)
+            pending = None
+    return result
+
+
+def percentile(values, p):
+    return values[min(len(values) - 1, int(len(values) * p / 100))]
+
+
+def histogram(values, width=40, bins=10):
+    low, high = values[0], values[-1]
+    step = (high - low) / bins or 1
+    counts = [0] * bins
+    for v in values:
+        counts[min(bins - 1, int((v - low) / step))] += 1
+    top = max(counts)
+    for i, count in enumerate(counts):
+        print("    %8.2f ms %6d %s" % (low + i * step, count, "#" * (count * width // top)))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("input", nargs="?", help="captured log, '-' for stdin")
+    parser.add_argument("--port", help="serial port to read from (requires pyserial)")
+    parser.add_argument("--baud", type=int, default=19200)
+    parser.add_argument("--duration", type=float, default=30.0, help="seconds to capture from --port")
+    parser.add_argument("--pair", action="append", metavar="START:END", help="event pair, repeatable")
+    parser.add_argument("--first", action="store_true", help="measure --pair from the earliest START")
+    parser.add_argument("--events", action="store_true", help="print decoded records")
+    parser.add_argument("--histogram", action="store_true", help="print a histogram for each pair")
+    args = parser.parse_args()
+
+    if args.port:
+        try:
+            import serial
+        except ImportError:
+            sys.exit("pyserial is required for --port, or capture to a file and decode that")
+        lines = []
+        with serial.Serial(args.port, args.baud, timeout=0.1) as port:
+            end = time.time() + args.duration
+            while time.time() < end:
+                lines.extend(l.decode("ascii", "replace") for l in port.readlines())
+    elif args.input:
+        stream = sys.stdin if args.input == "-" else open(args.input, errors="replace")
+        with stream:
+            lines = stream.readlines()
+    else:
+        parser.error("either an input file or --port is required")
+
+    records = list(parse(lines))
+
+    if args.events:
+        for event, t, payload in records:
+            print("%10.2f ms  %-18s %3d" % (t, EVENTS.get(event, "0x%02X" % event), payload))
+
+    pairs = DEFAULT_PAIRS
+    if args.pair:
+        pairs = []
+        for pair in args.pair:
+            start, _, end = pair.partition(":")
+            for name in (start, end):
+                if name not in IDS:
+                    parser.error("unknown event %s, known: %s" % (name, ", ".join(IDS)))
+            pairs.append((start, end, args.first))
+
+    dropped = sum(payload for event, _, payload in records if event == IDS["Dropped"])
+    print("%d records, %d dropped" % (len(records), dropped))
+
+    gaps = [payload / 16.0 for event, _, payload in records if event == IDS["AdcSampleLate"]]
+    if gaps:
+        print("%d late ADC samples, longest gap %.2f ms" % (len(gaps), max(gaps)))
+
+    for start, end, first in pairs:
+        values = sorted(latencies(records, IDS[start], IDS[end], first))
+        label = "%s -> %s%s" % (start, end, " (first)" if first else "")
+        if not values:
+            print("%-48s no samples" % label)
+            continue
+        print("%-48s n=%4d  min %8.2f  p50 %8.2f  p95 %8.2f  max %8.2f  avg %8.2f ms" % (
+            label, len(values), values[0], percentile(values, 50), percentile(values, 95), values[-1],
+            sum(values) / len(values)))
+        if args.histogram:
+            histogram(values)
+
+
+if __name__ == "__main__":
+    main()